@@ -0,0 +1,530 @@
+#include <NovusTypes.h>
+#include <Utils/Message.h>
+#include <Networking/Packet.h>
+#include <Networking/Connection.h>
+#include <asio/io_service.hpp>
+#include <asio/ip/tcp.hpp>
+#include "EngineLoopGroup.h"
+#include "Networking/Opcodes.h"
+#include "Networking/MessageHandler.h"
+#include "Utils/ServiceLocator.h"
+#include "Utils/PacketPool.h"
+#include "Utils/SPSCRingBuffer.h"
+#include "Utils/LatencyHistogram.h"
+#include "Utils/Metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Drives an EngineLoopGroup in-process with synthetic MSG_IN_NET_PACKET / MSG_IN_NET_DISCONNECT messages, the way the network
+// library feeds it, and reports throughput, handling latency, tick duration and allocations per packet for a few load shapes.
+// CMSG_HANDSHAKE is replaced by a handler that only records when the packet got to it, so what is measured is the engine
+// (queues, dirty connection tracking, shards and dispatch) and not the login path behind it.
+
+namespace
+{
+    std::atomic<u64> allocationCount(0);
+}
+
+void* operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace
+{
+    constexpr u32 MAX_IN_FLIGHT_PER_CONNECTION = 8;
+    constexpr std::chrono::seconds DRAIN_TIMEOUT(30);
+
+    struct BenchConfig
+    {
+        u32 connections = 10000;
+        u32 idleConnections = 20000;
+        u32 activeConnections = 256;
+        u32 packets = 200000;
+        u32 churnBatchSize = 256;
+        u32 churnBatches = 64;
+        u64 handlerWorkNS = 0;
+        u32 shards = 1;
+        std::string outputPath = "authmaster-bench.json";
+    };
+
+    struct BenchConnection
+    {
+        std::unique_ptr<asio::ip::tcp::socket> socket;
+        std::unique_ptr<Connection> connection;
+        SPSCRingBuffer<u64, 64> sendTimes;
+        std::atomic<u32> handledCount{ 0 };
+        u32 sentCount = 0;
+    };
+
+    struct ScenarioResult
+    {
+        std::string name;
+        u64 packets = 0;
+        f64 seconds = 0;
+        u64 latencyP50 = 0;
+        u64 latencyP99 = 0;
+        u64 latencyP999 = 0;
+        u64 latencyMax = 0;
+        u64 tickCount = 0;
+        u64 tickP50 = 0;
+        u64 tickP99 = 0;
+        u64 tickMax = 0;
+        f64 allocationsPerPacket = 0;
+    };
+
+    // Only rebuilt between scenarios while no packets are in flight, the handler reads it without locking
+    std::unordered_map<const Connection*, BenchConnection*> benchConnections;
+    LatencyHistogram handlingLatency;
+    std::atomic<u64> handledPackets(0);
+    u64 handlerWorkNS = 0;
+    bool timedOut = false; // A scenario gave up waiting for its packets, its numbers and those of later scenarios are meaningless
+
+    asio::io_service ioService;
+
+    u64 GetTimeNS()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Packet::connection is filled in by the network library, these keep the bench agnostic of how it holds on to it
+    void SetPacketConnection(Connection*& target, Connection* connection) { target = connection; }
+    void SetPacketConnection(std::shared_ptr<Connection>& target, Connection* connection) { target = std::shared_ptr<Connection>(connection, [](Connection*) {}); }
+
+    bool BenchHandshakeHandler(Packet* packet)
+    {
+        auto itr = benchConnections.find(&*packet->connection);
+
+        if (handlerWorkNS)
+        {
+            u64 workEnd = GetTimeNS() + handlerWorkNS;
+            while (GetTimeNS() < workEnd) { }
+        }
+
+        if (itr != benchConnections.end())
+        {
+            BenchConnection* benchConnection = itr->second;
+
+            u64 sendTime;
+            if (benchConnection->sendTimes.TryPop(sendTime))
+                handlingLatency.Record(GetTimeNS() - sendTime);
+
+            benchConnection->handledCount.fetch_add(1, std::memory_order_release);
+        }
+
+        handledPackets.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    std::vector<std::unique_ptr<BenchConnection>> CreateConnections(u32 count)
+    {
+        std::vector<std::unique_ptr<BenchConnection>> connections;
+        connections.reserve(count);
+
+        for (u32 i = 0; i < count; i++)
+        {
+            // The socket is never opened, the engine only copies the connection and tags it with an identity
+            std::unique_ptr<BenchConnection> benchConnection = std::make_unique<BenchConnection>();
+            benchConnection->socket = std::make_unique<asio::ip::tcp::socket>(ioService);
+            benchConnection->connection = std::make_unique<Connection>(benchConnection->socket.get());
+
+            benchConnections[benchConnection->connection.get()] = benchConnection.get();
+            connections.push_back(std::move(benchConnection));
+        }
+
+        return connections;
+    }
+
+    void SendPacket(EngineLoopGroup& engineLoopGroup, BenchConnection& benchConnection)
+    {
+        Packet* packet = PacketPool::Acquire();
+        packet->header.opcode = Opcode::CMSG_HANDSHAKE;
+        SetPacketConnection(packet->connection, benchConnection.connection.get());
+
+        benchConnection.sendTimes.Push(GetTimeNS());
+        benchConnection.sentCount++;
+
+        Message message;
+        message.code = MSG_IN_NET_PACKET;
+        message.object = packet;
+        engineLoopGroup.PassMessage(message);
+    }
+
+    void SendDisconnect(EngineLoopGroup& engineLoopGroup, BenchConnection& benchConnection)
+    {
+        Message message;
+        message.code = MSG_IN_NET_DISCONNECT;
+        message.object = new u64(benchConnection.connection->GetIdentity());
+        engineLoopGroup.PassMessage(message);
+    }
+
+    void DrainOutput(EngineLoopGroup& engineLoopGroup)
+    {
+        EngineOutputMessage message;
+        while (engineLoopGroup.TryGetMessage(message)) { }
+    }
+
+    bool WaitForHandledPackets(EngineLoopGroup& engineLoopGroup, u64 target)
+    {
+        auto deadline = std::chrono::steady_clock::now() + DRAIN_TIMEOUT;
+        while (handledPackets.load(std::memory_order_acquire) < target)
+        {
+            DrainOutput(engineLoopGroup);
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                printf("Timed out waiting for packets, %llu of %llu handled\n", static_cast<unsigned long long>(handledPackets.load()), static_cast<unsigned long long>(target));
+                timedOut = true;
+                return false;
+            }
+
+            std::this_thread::yield();
+        }
+
+        return true;
+    }
+
+    void WaitForPong(EngineLoopGroup& engineLoopGroup)
+    {
+        Message pingMessage;
+        pingMessage.code = MSG_IN_PING;
+        engineLoopGroup.PassMessage(pingMessage);
+
+        // Every shard answers the ping on its own
+        u32 pongCount = 0;
+        while (true)
+        {
+            EngineOutputMessage message;
+            while (engineLoopGroup.TryGetMessage(message))
+            {
+                if (message.type != EngineOutputType::PRINT)
+                    continue;
+
+                if (std::strncmp(message.text, "PONG!", 5) == 0 && ++pongCount == engineLoopGroup.GetShardCount())
+                    return;
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    // Pings are served from the control lane ahead of network traffic. Everything passed before the first ping has been sorted
+    // into the lanes by the time a later ping comes back, so keep pinging until a tick started with empty lanes.
+    void WaitForEngine(EngineLoopGroup& engineLoopGroup)
+    {
+        WaitForPong(engineLoopGroup);
+        while (true)
+        {
+            WaitForPong(engineLoopGroup);
+
+            MetricsSnapshot snapshot;
+            Metrics::GetSnapshot(snapshot);
+
+            if (snapshot.gauges[static_cast<u32>(MetricGauge::CLIENT_LANE_DEPTH)] == 0 && snapshot.gauges[static_cast<u32>(MetricGauge::INTERNAL_LANE_DEPTH)] == 0)
+                return;
+        }
+    }
+
+    void DisconnectAll(EngineLoopGroup& engineLoopGroup, std::vector<std::unique_ptr<BenchConnection>>& connections)
+    {
+        for (std::unique_ptr<BenchConnection>& benchConnection : connections)
+        {
+            if (benchConnection->connection->GetIdentity())
+                SendDisconnect(engineLoopGroup, *benchConnection);
+        }
+
+        WaitForEngine(engineLoopGroup);
+        connections.clear();
+        benchConnections.clear();
+    }
+
+    struct ScenarioMeasurement
+    {
+        std::chrono::steady_clock::time_point start;
+        u64 startHandledPackets;
+        u64 startAllocations;
+    };
+
+    ScenarioMeasurement BeginMeasurement()
+    {
+        handlingLatency.Reset();
+        Metrics::Reset();
+
+        ScenarioMeasurement measurement;
+        measurement.startHandledPackets = handledPackets.load();
+        measurement.startAllocations = allocationCount.load();
+        measurement.start = std::chrono::steady_clock::now();
+        return measurement;
+    }
+
+    ScenarioResult EndMeasurement(const char* name, const ScenarioMeasurement& measurement)
+    {
+        ScenarioResult result;
+        result.seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - measurement.start).count();
+        result.name = name;
+        result.packets = handledPackets.load() - measurement.startHandledPackets;
+        result.allocationsPerPacket = result.packets ? static_cast<f64>(allocationCount.load() - measurement.startAllocations) / result.packets : 0;
+
+        result.latencyP50 = handlingLatency.GetPercentile(50.0);
+        result.latencyP99 = handlingLatency.GetPercentile(99.0);
+        result.latencyP999 = handlingLatency.GetPercentile(99.9);
+        result.latencyMax = handlingLatency.GetMax();
+
+        MetricsSnapshot snapshot;
+        Metrics::GetSnapshot(snapshot);
+
+        const LatencyHistogram& tickDurations = snapshot.histograms[static_cast<u32>(MetricHistogram::TICK_DURATION)];
+        result.tickCount = tickDurations.GetCount();
+        result.tickP50 = tickDurations.GetPercentile(50.0);
+        result.tickP99 = tickDurations.GetPercentile(99.0);
+        result.tickMax = tickDurations.GetMax();
+        return result;
+    }
+
+    // Every connection is new and sends its first packet at the same time, like clients reconnecting after a restart
+    ScenarioResult RunHandshakeStorm(EngineLoopGroup& engineLoopGroup, const BenchConfig& config)
+    {
+        std::vector<std::unique_ptr<BenchConnection>> connections = CreateConnections(config.connections);
+
+        ScenarioMeasurement measurement = BeginMeasurement();
+        for (std::unique_ptr<BenchConnection>& benchConnection : connections)
+        {
+            SendPacket(engineLoopGroup, *benchConnection);
+        }
+        WaitForHandledPackets(engineLoopGroup, measurement.startHandledPackets + connections.size());
+        ScenarioResult result = EndMeasurement("handshake_storm", measurement);
+
+        DisconnectAll(engineLoopGroup, connections);
+        return result;
+    }
+
+    // A lot of connections that stay quiet while a few keep sending, only the active ones should cost anything per tick
+    ScenarioResult RunIdleConnections(EngineLoopGroup& engineLoopGroup, const BenchConfig& config)
+    {
+        u32 activeCount = std::min(config.activeConnections, config.idleConnections);
+        std::vector<std::unique_ptr<BenchConnection>> connections = CreateConnections(config.idleConnections);
+
+        u64 establishedPackets = handledPackets.load() + connections.size();
+        for (std::unique_ptr<BenchConnection>& benchConnection : connections)
+        {
+            SendPacket(engineLoopGroup, *benchConnection);
+        }
+        WaitForHandledPackets(engineLoopGroup, establishedPackets);
+
+        ScenarioMeasurement measurement = BeginMeasurement();
+        u32 sent = 0;
+        while (sent < config.packets)
+        {
+            bool sentAny = false;
+            for (u32 i = 0; i < activeCount && sent < config.packets; i++)
+            {
+                BenchConnection& benchConnection = *connections[i];
+                if (benchConnection.sentCount - benchConnection.handledCount.load(std::memory_order_acquire) >= MAX_IN_FLIGHT_PER_CONNECTION)
+                    continue;
+
+                SendPacket(engineLoopGroup, benchConnection);
+                sentAny = true;
+                sent++;
+            }
+
+            if (!sentAny)
+            {
+                DrainOutput(engineLoopGroup);
+                std::this_thread::yield();
+            }
+        }
+        WaitForHandledPackets(engineLoopGroup, measurement.startHandledPackets + sent);
+        ScenarioResult result = EndMeasurement("idle_connections", measurement);
+
+        DisconnectAll(engineLoopGroup, connections);
+        return result;
+    }
+
+    // Connections come and go in batches, every one of them sends two packets before disconnecting
+    ScenarioResult RunChurn(EngineLoopGroup& engineLoopGroup, const BenchConfig& config)
+    {
+        std::vector<std::unique_ptr<BenchConnection>> connections = CreateConnections(config.churnBatchSize * config.churnBatches);
+
+        ScenarioMeasurement measurement = BeginMeasurement();
+        u64 target = measurement.startHandledPackets;
+        for (u32 batch = 0; batch < config.churnBatches; batch++)
+        {
+            u32 begin = batch * config.churnBatchSize;
+            u32 end = begin + config.churnBatchSize;
+
+            for (u32 i = begin; i < end; i++)
+            {
+                SendPacket(engineLoopGroup, *connections[i]);
+                SendPacket(engineLoopGroup, *connections[i]);
+            }
+
+            target += config.churnBatchSize * 2;
+            WaitForHandledPackets(engineLoopGroup, target);
+
+            for (u32 i = begin; i < end; i++)
+            {
+                SendDisconnect(engineLoopGroup, *connections[i]);
+            }
+        }
+        WaitForEngine(engineLoopGroup);
+        ScenarioResult result = EndMeasurement("churn", measurement);
+
+        connections.clear();
+        benchConnections.clear();
+        return result;
+    }
+
+    void PrintResult(const ScenarioResult& result)
+    {
+        printf("%-18s %10llu packets %12.0f packets/s  latency p50 %8.1fus p99 %8.1fus p999 %8.1fus  tick p50 %8.1fus p99 %8.1fus  %6.2f allocs/packet\n",
+            result.name.c_str(), static_cast<unsigned long long>(result.packets), result.packets / result.seconds,
+            result.latencyP50 / 1000.0, result.latencyP99 / 1000.0, result.latencyP999 / 1000.0,
+            result.tickP50 / 1000.0, result.tickP99 / 1000.0, result.allocationsPerPacket);
+    }
+
+    bool WriteResults(const std::string& path, const BenchConfig& config, const std::vector<ScenarioResult>& results)
+    {
+        FILE* file = std::fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+
+        std::fprintf(file, "{\n  \"config\": { \"connections\": %u, \"idle_connections\": %u, \"active_connections\": %u, \"packets\": %u, \"churn_batch_size\": %u, \"churn_batches\": %u, \"handler_work_ns\": %llu, \"shards\": %u },\n",
+            config.connections, config.idleConnections, config.activeConnections, config.packets, config.churnBatchSize, config.churnBatches, static_cast<unsigned long long>(config.handlerWorkNS), config.shards);
+        std::fprintf(file, "  \"scenarios\": [\n");
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const ScenarioResult& result = results[i];
+            std::fprintf(file, "    { \"name\": \"%s\", \"packets\": %llu, \"seconds\": %.6f, \"packets_per_second\": %.1f, "
+                "\"latency_ns\": { \"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu }, "
+                "\"tick_ns\": { \"count\": %llu, \"p50\": %llu, \"p99\": %llu, \"max\": %llu }, "
+                "\"allocations_per_packet\": %.3f }%s\n",
+                result.name.c_str(), static_cast<unsigned long long>(result.packets), result.seconds, result.packets / result.seconds,
+                static_cast<unsigned long long>(result.latencyP50), static_cast<unsigned long long>(result.latencyP99),
+                static_cast<unsigned long long>(result.latencyP999), static_cast<unsigned long long>(result.latencyMax),
+                static_cast<unsigned long long>(result.tickCount), static_cast<unsigned long long>(result.tickP50),
+                static_cast<unsigned long long>(result.tickP99), static_cast<unsigned long long>(result.tickMax),
+                result.allocationsPerPacket, i + 1 < results.size() ? "," : "");
+        }
+
+        std::fprintf(file, "  ]\n}\n");
+        std::fclose(file);
+        return true;
+    }
+
+    bool ParseArguments(i32 argc, char** argv, BenchConfig& config)
+    {
+        for (i32 i = 1; i < argc; i++)
+        {
+            const char* argument = argv[i];
+            if (i + 1 >= argc)
+                return false;
+
+            const char* value = argv[++i];
+            if (std::strcmp(argument, "--connections") == 0)
+                config.connections = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(argument, "--idle-connections") == 0)
+                config.idleConnections = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(argument, "--active-connections") == 0)
+                config.activeConnections = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(argument, "--packets") == 0)
+                config.packets = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(argument, "--churn-batch-size") == 0)
+                config.churnBatchSize = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(argument, "--churn-batches") == 0)
+                config.churnBatches = std::strtoul(value, nullptr, 10);
+            else if (std::strcmp(argument, "--handler-work-ns") == 0)
+                config.handlerWorkNS = std::strtoull(value, nullptr, 10);
+            else if (std::strcmp(argument, "--shards") == 0)
+                config.shards = std::max<u32>(std::strtoul(value, nullptr, 10), 1);
+            else if (std::strcmp(argument, "--output") == 0)
+                config.outputPath = value;
+            else
+                return false;
+        }
+
+        return true;
+    }
+}
+
+i32 main(i32 argc, char** argv)
+{
+    BenchConfig config;
+    if (!ParseArguments(argc, argv, config))
+    {
+        printf("Usage: authmaster-bench [--connections N] [--idle-connections N] [--active-connections N] [--packets N] "
+            "[--churn-batch-size N] [--churn-batches N] [--handler-work-ns N] [--shards N] [--output file.json]\n");
+        return 1;
+    }
+    handlerWorkNS = config.handlerWorkNS;
+
+    EngineLoopGroup engineLoopGroup(config.shards, 30, EngineLoopMode::EVENT_DRIVEN);
+    engineLoopGroup.Start();
+    WaitForEngine(engineLoopGroup);
+
+    // The engine is set up and idle once the ping came back, nothing is dispatching while the handler is swapped
+    ServiceLocator::GetClientMessageHandler()->SetMessageHandler(Opcode::CMSG_HANDSHAKE, BenchHandshakeHandler);
+
+    std::vector<ScenarioResult> results;
+    ScenarioResult (*scenarios[])(EngineLoopGroup&, const BenchConfig&) = { RunHandshakeStorm, RunIdleConnections, RunChurn };
+    for (auto scenario : scenarios)
+    {
+        results.push_back(scenario(engineLoopGroup, config));
+        if (timedOut)
+            break;
+
+        PrintResult(results.back());
+    }
+
+    engineLoopGroup.Stop();
+    while (true)
+    {
+        EngineOutputMessage message;
+        if (engineLoopGroup.TryGetMessage(message))
+        {
+            if (message.type == EngineOutputType::EXIT_CONFIRM)
+                break;
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    if (timedOut)
+    {
+        printf("A scenario timed out, no results written\n");
+        return 1;
+    }
+
+    if (!WriteResults(config.outputPath, config, results))
+    {
+        printf("Failed to write %s\n", config.outputPath.c_str());
+        return 1;
+    }
+
+    printf("Results written to %s\n", config.outputPath.c_str());
+    return 0;
+}
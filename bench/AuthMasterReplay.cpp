@@ -0,0 +1,303 @@
+#include <NovusTypes.h>
+#include <Utils/Message.h>
+#include <Networking/Packet.h>
+#include <Networking/Connection.h>
+#include <asio/io_service.hpp>
+#include <asio/ip/tcp.hpp>
+#include "EngineLoopGroup.h"
+#include "Utils/PacketCapture.h"
+#include "Utils/PacketPool.h"
+#include "Utils/LatencyHistogram.h"
+#include "Utils/Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Feeds a capture written by 'capture start <file>' back into an in-process EngineLoopGroup, either at the pace it was recorded at
+// or as fast as the engine takes it, and reports throughput, handler time and tick duration. Unlike authmaster-bench the real
+// handlers run, so a capture of production traffic measures the login path behind the engine as well. Replies are written to
+// sockets that are never opened and go nowhere.
+
+namespace
+{
+    constexpr u32 DISCONNECT_RETRY_INTERVAL = 64; // Records between two tries at the disconnects still waiting for an identity
+
+    struct ReplayConfig
+    {
+        std::string capturePath;
+        f64 speed = 1.0; // Multiple of the recorded pace, 0 replays as fast as possible
+        u32 shards = 1;
+    };
+
+    struct ReplayRecord
+    {
+        const PacketCaptureRecord* record;
+        const u8* payload;
+    };
+
+    struct ReplayConnection
+    {
+        std::unique_ptr<asio::ip::tcp::socket> socket;
+        std::unique_ptr<Connection> connection;
+    };
+
+    asio::io_service ioService;
+
+    // Packet::connection is filled in by the network library, these keep the replay agnostic of how it holds on to it
+    void SetPacketConnection(Connection*& target, Connection* connection) { target = connection; }
+    void SetPacketConnection(std::shared_ptr<Connection>& target, Connection* connection) { target = std::shared_ptr<Connection>(connection, [](Connection*) {}); }
+
+    void DrainOutput(EngineLoopGroup& engineLoopGroup)
+    {
+        EngineOutputMessage message;
+        while (engineLoopGroup.TryGetMessage(message)) { }
+    }
+
+    void WaitForPong(EngineLoopGroup& engineLoopGroup)
+    {
+        Message pingMessage;
+        pingMessage.code = MSG_IN_PING;
+        engineLoopGroup.PassMessage(pingMessage);
+
+        // Every shard answers the ping on its own
+        u32 pongCount = 0;
+        while (true)
+        {
+            EngineOutputMessage message;
+            while (engineLoopGroup.TryGetMessage(message))
+            {
+                if (message.type != EngineOutputType::PRINT)
+                    continue;
+
+                if (std::strncmp(message.text, "PONG!", 5) == 0 && ++pongCount == engineLoopGroup.GetShardCount())
+                    return;
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    // See authmaster-bench, keeps pinging until a tick started with empty lanes
+    void WaitForEngine(EngineLoopGroup& engineLoopGroup)
+    {
+        WaitForPong(engineLoopGroup);
+        while (true)
+        {
+            WaitForPong(engineLoopGroup);
+
+            MetricsSnapshot snapshot;
+            Metrics::GetSnapshot(snapshot);
+
+            if (snapshot.gauges[static_cast<u32>(MetricGauge::CLIENT_LANE_DEPTH)] == 0 && snapshot.gauges[static_cast<u32>(MetricGauge::INTERNAL_LANE_DEPTH)] == 0)
+                return;
+        }
+    }
+
+    ReplayConnection& GetConnection(std::unordered_map<u64, ReplayConnection>& connections, u64 connectionId)
+    {
+        ReplayConnection& replayConnection = connections[connectionId];
+        if (!replayConnection.connection)
+        {
+            // The socket is never opened, the engine only copies the connection and tags it with an identity
+            replayConnection.socket = std::make_unique<asio::ip::tcp::socket>(ioService);
+            replayConnection.connection = std::make_unique<Connection>(replayConnection.socket.get());
+        }
+
+        return replayConnection;
+    }
+
+    void SendPacket(EngineLoopGroup& engineLoopGroup, ReplayConnection& replayConnection, const ReplayRecord& replayRecord)
+    {
+        Packet* packet = PacketPool::Acquire();
+        packet->header.opcode = replayRecord.record->opcode;
+        SetPacketPayload(*packet, replayRecord.payload, replayRecord.record->payloadSize);
+        SetPacketConnection(packet->connection, replayConnection.connection.get());
+
+        Message message;
+        message.code = replayRecord.record->type == PacketCaptureType::INTERNAL_PACKET ? MSG_IN_INTERNAL_NET_PACKET : MSG_IN_NET_PACKET;
+        message.object = packet;
+        engineLoopGroup.PassMessage(message);
+    }
+
+    // The engine tags the connection with an identity once it handled its first packet, a disconnect needs that identity.
+    // Returns false if the engine hasn't yet, the caller keeps the disconnect around and tries again later
+    bool TrySendDisconnect(EngineLoopGroup& engineLoopGroup, ReplayConnection& replayConnection)
+    {
+        u64 identity = replayConnection.connection->GetIdentity();
+        if (!identity)
+            return false;
+
+        Message message;
+        message.code = MSG_IN_NET_DISCONNECT;
+        message.object = new u64(identity);
+        engineLoopGroup.PassMessage(message);
+        return true;
+    }
+
+    void SendPendingDisconnects(EngineLoopGroup& engineLoopGroup, std::vector<ReplayConnection*>& pendingDisconnects)
+    {
+        pendingDisconnects.erase(std::remove_if(pendingDisconnects.begin(), pendingDisconnects.end(),
+            [&engineLoopGroup](ReplayConnection* replayConnection) { return TrySendDisconnect(engineLoopGroup, *replayConnection); }), pendingDisconnects.end());
+    }
+
+    bool LoadRecords(const PacketCaptureReader& reader, std::vector<ReplayRecord>& records)
+    {
+        size_t offset = 0;
+        ReplayRecord replayRecord;
+        while (reader.Next(offset, replayRecord.record, replayRecord.payload))
+        {
+            records.push_back(replayRecord);
+        }
+
+        // Shards append their records once per tick, so the file is only ordered per shard
+        std::stable_sort(records.begin(), records.end(), [](const ReplayRecord& a, const ReplayRecord& b) { return a.record->timeNS < b.record->timeNS; });
+        return !records.empty();
+    }
+
+    bool ParseArguments(i32 argc, char** argv, ReplayConfig& config)
+    {
+        for (i32 i = 1; i < argc; i++)
+        {
+            const char* argument = argv[i];
+            if (i + 1 >= argc)
+                return false;
+
+            const char* value = argv[++i];
+            if (std::strcmp(argument, "--capture") == 0)
+                config.capturePath = value;
+            else if (std::strcmp(argument, "--speed") == 0)
+                config.speed = std::max(std::strtod(value, nullptr), 0.0);
+            else if (std::strcmp(argument, "--shards") == 0)
+                config.shards = std::max<u32>(std::strtoul(value, nullptr, 10), 1);
+            else
+                return false;
+        }
+
+        return !config.capturePath.empty();
+    }
+}
+
+i32 main(i32 argc, char** argv)
+{
+    ReplayConfig config;
+    if (!ParseArguments(argc, argv, config))
+    {
+        printf("Usage: authmaster-replay --capture file [--speed X (1 is the recorded pace, 0 as fast as possible)] [--shards N]\n");
+        return 1;
+    }
+
+    PacketCaptureReader reader;
+    if (!reader.Open(config.capturePath))
+    {
+        printf("Failed to open %s, or it is not a capture\n", config.capturePath.c_str());
+        return 1;
+    }
+
+    std::vector<ReplayRecord> records;
+    if (!LoadRecords(reader, records))
+    {
+        printf("%s has no records\n", config.capturePath.c_str());
+        return 1;
+    }
+
+    EngineLoopGroup engineLoopGroup(config.shards, 30, EngineLoopMode::EVENT_DRIVEN);
+    engineLoopGroup.Start();
+    WaitForEngine(engineLoopGroup);
+
+    std::unordered_map<u64, ReplayConnection> connections;
+    std::vector<ReplayConnection*> pendingDisconnects; // Elements of an unordered_map stay where they are when it grows
+    u64 packetCount = 0;
+    u64 skippedDisconnects = 0;
+    u32 recordsSinceRetry = 0;
+
+    Metrics::Reset();
+    auto start = std::chrono::steady_clock::now();
+    for (const ReplayRecord& replayRecord : records)
+    {
+        if (config.speed > 0)
+        {
+            auto sendTime = start + std::chrono::nanoseconds(static_cast<u64>(replayRecord.record->timeNS / config.speed));
+            while (std::chrono::steady_clock::now() < sendTime)
+            {
+                DrainOutput(engineLoopGroup);
+                SendPendingDisconnects(engineLoopGroup, pendingDisconnects);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+
+        if (!pendingDisconnects.empty() && ++recordsSinceRetry >= DISCONNECT_RETRY_INTERVAL)
+        {
+            SendPendingDisconnects(engineLoopGroup, pendingDisconnects);
+            recordsSinceRetry = 0;
+        }
+
+        ReplayConnection& replayConnection = GetConnection(connections, replayRecord.record->connectionId);
+        if (replayRecord.record->type == PacketCaptureType::DISCONNECT)
+        {
+            // The connection is kept until the end, packets still in flight point at it. Waiting for the engine here would stall
+            // the replay, and for a connection whose packets were all rate limited it never comes
+            if (!TrySendDisconnect(engineLoopGroup, replayConnection))
+                pendingDisconnects.push_back(&replayConnection);
+        }
+        else
+        {
+            SendPacket(engineLoopGroup, replayConnection, replayRecord);
+            packetCount++;
+        }
+    }
+    WaitForEngine(engineLoopGroup);
+
+    // Every packet has been handled now, a connection that still has no identity won't get one
+    if (!pendingDisconnects.empty())
+    {
+        SendPendingDisconnects(engineLoopGroup, pendingDisconnects);
+        skippedDisconnects = pendingDisconnects.size();
+        WaitForEngine(engineLoopGroup);
+    }
+    f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+    MetricsSnapshot snapshot;
+    Metrics::GetSnapshot(snapshot);
+
+    const LatencyHistogram& handlerTimes = snapshot.histograms[static_cast<u32>(MetricHistogram::HANDLER_TIME)];
+    const LatencyHistogram& tickDurations = snapshot.histograms[static_cast<u32>(MetricHistogram::TICK_DURATION)];
+    f64 recordedSeconds = records.back().record->timeNS / 1000000000.0;
+
+    printf("%llu packets, %llu connections, recorded over %.3fs, replayed in %.3fs (%.0f packets/s)\n",
+        static_cast<unsigned long long>(packetCount), static_cast<unsigned long long>(snapshot.counters[static_cast<u32>(MetricCounter::CONNECTIONS_OPENED)]),
+        recordedSeconds, seconds, packetCount / seconds);
+    printf("handler p50 %.1fus p99 %.1fus max %.1fus  tick p50 %.1fus p99 %.1fus max %.1fus  %llu ticks\n",
+        handlerTimes.GetPercentile(50.0) / 1000.0, handlerTimes.GetPercentile(99.0) / 1000.0, handlerTimes.GetMax() / 1000.0,
+        tickDurations.GetPercentile(50.0) / 1000.0, tickDurations.GetPercentile(99.0) / 1000.0, tickDurations.GetMax() / 1000.0,
+        static_cast<unsigned long long>(tickDurations.GetCount()));
+    printf("packets shed %llu, rate limited %llu, dropped %llu, disconnects skipped %llu\n",
+        static_cast<unsigned long long>(snapshot.counters[static_cast<u32>(MetricCounter::PACKETS_SHED)]),
+        static_cast<unsigned long long>(snapshot.counters[static_cast<u32>(MetricCounter::PACKETS_RATE_LIMITED)]),
+        static_cast<unsigned long long>(snapshot.counters[static_cast<u32>(MetricCounter::PACKETS_DROPPED)]),
+        static_cast<unsigned long long>(skippedDisconnects));
+
+    engineLoopGroup.Stop();
+    while (true)
+    {
+        EngineOutputMessage message;
+        if (engineLoopGroup.TryGetMessage(message))
+        {
+            if (message.type == EngineOutputType::EXIT_CONFIRM)
+                break;
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <NovusTypes.h>
+#include "Cryptography/SHA256.h"
+#include "Cryptography/SHA256MultiBuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Throughput of SHA256MultiBuffer::HashBatch for every kernel the CPU supports, against hashing the same messages one at a time.
+// The messages are 64 bytes like the nonce | verifier messages CryptoWorkerPool verifies.
+
+namespace
+{
+    constexpr size_t MESSAGE_SIZE = 64;
+    constexpr size_t BATCH_SIZE = 256;
+    constexpr size_t ROUNDS = 2000;
+
+    f64 GetSeconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+i32 main()
+{
+    std::vector<u8> messages(BATCH_SIZE * MESSAGE_SIZE);
+    for (size_t i = 0; i < messages.size(); i++)
+    {
+        messages[i] = static_cast<u8>(i * 31 + 7);
+    }
+
+    std::vector<u8> digests(BATCH_SIZE * SHA256::DIGEST_SIZE);
+    std::vector<SHA256BatchEntry> entries(BATCH_SIZE);
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        entries[i].data = &messages[i * MESSAGE_SIZE];
+        entries[i].size = MESSAGE_SIZE;
+        entries[i].digest = &digests[i * SHA256::DIGEST_SIZE];
+    }
+
+    // One at a time, what the crypto workers did before batching
+    u8 checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; round++)
+    {
+        for (size_t i = 0; i < BATCH_SIZE; i++)
+        {
+            u8 digest[SHA256::DIGEST_SIZE];
+            SHA256::Hash(entries[i].data, entries[i].size, digest);
+            checksum ^= digest[round % SHA256::DIGEST_SIZE];
+        }
+    }
+    f64 singleHashesPerSecond = (ROUNDS * BATCH_SIZE) / GetSeconds(start);
+    printf("%-12s %6s %14.0f hashes/s %6.2fx\n", "SHA256::Hash", "1", singleHashesPerSecond, 1.0);
+
+    std::vector<u8> referenceDigests(digests.size());
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        SHA256::Hash(entries[i].data, entries[i].size, *reinterpret_cast<u8(*)[SHA256::DIGEST_SIZE]>(&referenceDigests[i * SHA256::DIGEST_SIZE]));
+    }
+
+    u32 previousLaneCount = 0;
+    for (u32 laneLimit : { 16u, 8u, 4u, 1u })
+    {
+        SHA256MultiBuffer::SetMaxLaneCount(laneLimit);
+        u32 laneCount = SHA256MultiBuffer::GetLaneCount();
+        if (laneCount == previousLaneCount)
+            continue;
+
+        previousLaneCount = laneCount;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < ROUNDS; round++)
+        {
+            SHA256MultiBuffer::HashBatch(entries.data(), entries.size());
+            checksum ^= digests[round % digests.size()];
+        }
+        f64 hashesPerSecond = (ROUNDS * BATCH_SIZE) / GetSeconds(start);
+
+        bool matches = memcmp(digests.data(), referenceDigests.data(), digests.size()) == 0;
+        printf("%-12s %6u %14.0f hashes/s %6.2fx%s\n", SHA256MultiBuffer::GetKernelName(), laneCount, hashesPerSecond, hashesPerSecond / singleHashesPerSecond, matches ? "" : " DIGEST MISMATCH");
+    }
+
+    // Keeps the loops above from being optimized away
+    printf("checksum %u\n", checksum);
+    return 0;
+}
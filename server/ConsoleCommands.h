@@ -34,6 +34,8 @@
 
 #include "ConsoleCommands/QuitCommand.h"
 #include "ConsoleCommands/PingCommand.h"
+#include "ConsoleCommands/StatsCommand.h"
+#include "ConsoleCommands/CaptureCommand.h"
 
 class ConsoleCommandHandler
 {
@@ -42,9 +44,11 @@ public:
     {
         RegisterCommand("quit"_h, &QuitCommand);
         RegisterCommand("ping"_h, &PingCommand);
+        RegisterCommand("stats"_h, &StatsCommand);
+        RegisterCommand("capture"_h, &CaptureCommand);
     }
 
-    void HandleCommand(EngineLoop& engineLoop, std::string& command)
+    void HandleCommand(EngineLoopGroup& engineLoopGroup, std::string& command)
     {
         if (command.size() == 0)
             return;
@@ -56,7 +60,7 @@ public:
         if (commandHandler != commandHandlers.end())
         {
             splitCommand.erase(splitCommand.begin());
-            commandHandler->second(engineLoop, splitCommand);
+            commandHandler->second(engineLoopGroup, splitCommand);
         }
         else
         {
@@ -65,10 +69,10 @@ public:
     }
 
 private:
-    void RegisterCommand(u32 id, const std::function<void(EngineLoop&, std::vector<std::string>)>& handler)
+    void RegisterCommand(u32 id, const std::function<void(EngineLoopGroup&, std::vector<std::string>)>& handler)
     {
         commandHandlers.insert_or_assign(id, handler);
     }
 
-    std::map<u16, std::function<void(EngineLoop&, std::vector<std::string>)>> commandHandlers = {};
+    std::map<u16, std::function<void(EngineLoopGroup&, std::vector<std::string>)>> commandHandlers = {};
 };
@@ -0,0 +1,74 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include "../EngineLoopGroup.h"
+#include "../Utils/PacketCapture.h"
+#include "../Utils/ServiceLocator.h"
+
+// capture                 Print whether packets are being captured
+// capture start <file>    Write every packet and disconnect the engine shards receive to file, replay it with authmaster-replay
+// capture stop            Stop capturing
+
+void CaptureCommand(EngineLoopGroup& engineLoopGroup, std::vector<std::string> subCommands)
+{
+    PacketCaptureWriter* packetCaptureWriter = ServiceLocator::GetPacketCaptureWriter();
+    if (!packetCaptureWriter)
+    {
+        NC_LOG_WARNING("The packet capture is not set up yet");
+        return;
+    }
+
+    if (subCommands.size() == 2 && subCommands[0] == "start")
+    {
+        if (packetCaptureWriter->IsCapturing())
+            NC_LOG_WARNING("Already capturing, stop the current capture first");
+        else if (packetCaptureWriter->Start(subCommands[1]))
+            NC_LOG_MESSAGE("Capturing packets to " + subCommands[1]);
+        else
+            NC_LOG_WARNING("Could not open " + subCommands[1] + " for writing");
+
+        return;
+    }
+
+    if (subCommands.size() == 1 && subCommands[0] == "stop")
+    {
+        // Records still buffered by a shard for this tick are thrown away
+        u64 recordCount = packetCaptureWriter->GetRecordCount();
+        packetCaptureWriter->Stop();
+        NC_LOG_MESSAGE("Stopped capturing, " + std::to_string(recordCount) + " records written");
+        return;
+    }
+
+    if (subCommands.size() > 0)
+    {
+        NC_LOG_WARNING("Usage: capture start <file> | capture stop");
+        return;
+    }
+
+    if (packetCaptureWriter->IsCapturing())
+        NC_LOG_MESSAGE("Capturing packets, " + std::to_string(packetCaptureWriter->GetRecordCount()) + " records written");
+    else
+        NC_LOG_MESSAGE("Not capturing packets");
+}
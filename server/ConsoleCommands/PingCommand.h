@@ -23,11 +23,13 @@
 */
 #pragma once
 #include <Utils/Message.h>
-#include "../EngineLoop.h"
+#include "../EngineLoopGroup.h"
 
-void PingCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands)
+void PingCommand(EngineLoopGroup& engineLoopGroup, std::vector<std::string> subCommands)
 {
     Message pingMessage;
     pingMessage.code = MSG_IN_PING;
-    engineLoop.PassMessage(pingMessage);
+
+    // Every shard answers on its own
+    engineLoopGroup.PassMessage(pingMessage);
 }
\ No newline at end of file
@@ -23,9 +23,9 @@
 */
 #pragma once
 #include <Utils/Message.h>
-#include "../EngineLoop.h"
+#include "../EngineLoopGroup.h"
 
-void QuitCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands)
+void QuitCommand(EngineLoopGroup& engineLoopGroup, std::vector<std::string> subCommands)
 {
-    engineLoop.Stop();
+    engineLoopGroup.Stop();
 }
\ No newline at end of file
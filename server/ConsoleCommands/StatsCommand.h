@@ -0,0 +1,127 @@
+/*
+    MIT License
+
+    Copyright (c) 2018-2019 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/DebugHandler.h>
+#include <cstdlib>
+#include "../EngineLoopGroup.h"
+#include "../Utils/Metrics.h"
+#include "../Utils/ServiceLocator.h"
+#include "../Networking/MessageHandler.h"
+
+// stats                          Print a snapshot of the metrics
+// stats dump <file> <seconds>    Append a snapshot to file every few seconds
+// stats dump off                 Stop dumping
+// stats opcodes [on|off|reset]   Per-opcode dispatch profile of the client and server message handlers
+
+void PrintOpcodeProfile(const char* name, MessageHandler* messageHandler)
+{
+    MessageHandlerProfile profile;
+    messageHandler->GetProfile(profile);
+
+    char line[160];
+    for (u32 i = 0; i < Opcode::OPCODE_MAX_COUNT; i++)
+    {
+        const OpcodeProfile& opcodeProfile = profile.opcodes[i];
+        if (opcodeProfile.calls == 0)
+            continue;
+
+        snprintf(line, sizeof(line), "%s.opcode.%u calls %llu deferrals %llu total_ns %llu mean_ns %llu max_ns %llu", name, i,
+            static_cast<unsigned long long>(opcodeProfile.calls), static_cast<unsigned long long>(opcodeProfile.deferrals),
+            static_cast<unsigned long long>(opcodeProfile.totalNS), static_cast<unsigned long long>(opcodeProfile.totalNS / opcodeProfile.calls),
+            static_cast<unsigned long long>(opcodeProfile.maxNS));
+        NC_LOG_MESSAGE(std::string(line));
+    }
+
+    NC_LOG_MESSAGE(std::string(name) + ".rejected_opcodes " + std::to_string(profile.rejectedOpcodes));
+}
+
+void StatsCommand(EngineLoopGroup& engineLoopGroup, std::vector<std::string> subCommands)
+{
+    if (subCommands.size() > 0 && subCommands[0] == "dump")
+    {
+        if (subCommands.size() == 2 && subCommands[1] == "off")
+        {
+            Metrics::StopDumping();
+            NC_LOG_MESSAGE("Stopped dumping metrics");
+            return;
+        }
+
+        u32 interval = subCommands.size() == 3 ? std::strtoul(subCommands[2].c_str(), nullptr, 10) : 0;
+        if (interval == 0)
+        {
+            NC_LOG_WARNING("Usage: stats dump <file> <seconds> | stats dump off");
+            return;
+        }
+
+        if (Metrics::StartDumping(subCommands[1], std::chrono::seconds(interval)))
+            NC_LOG_MESSAGE("Dumping metrics to " + subCommands[1] + " every " + subCommands[2] + " seconds");
+        else
+            NC_LOG_WARNING("Could not open " + subCommands[1] + " for writing");
+
+        return;
+    }
+
+    if (subCommands.size() > 0 && subCommands[0] == "opcodes")
+    {
+        MessageHandler* messageHandlers[] = { ServiceLocator::GetClientMessageHandler(), ServiceLocator::GetInternalMessageHandler() };
+        if (!messageHandlers[0] || !messageHandlers[1])
+        {
+            NC_LOG_WARNING("The message handlers are not set up yet");
+            return;
+        }
+
+        if (subCommands.size() == 2 && (subCommands[1] == "on" || subCommands[1] == "off" || subCommands[1] == "reset"))
+        {
+            for (MessageHandler* messageHandler : messageHandlers)
+            {
+                if (subCommands[1] == "reset")
+                    messageHandler->ResetProfile();
+                else
+                    messageHandler->SetProfilingEnabled(subCommands[1] == "on");
+            }
+
+            NC_LOG_MESSAGE("Opcode profiling " + subCommands[1]);
+            return;
+        }
+
+        if (!messageHandlers[0]->IsProfilingEnabled())
+            NC_LOG_MESSAGE("Opcode profiling is off, only rejected opcodes are counted. Enable it with 'stats opcodes on'");
+
+        PrintOpcodeProfile("client", messageHandlers[0]);
+        PrintOpcodeProfile("internal", messageHandlers[1]);
+        return;
+    }
+
+    MetricsSnapshot snapshot;
+    Metrics::GetSnapshot(snapshot);
+
+    std::vector<std::string> lines;
+    lines.push_back("engine_shards " + std::to_string(engineLoopGroup.GetShardCount()));
+    Metrics::FormatSnapshot(snapshot, lines);
+
+    for (const std::string& line : lines)
+    {
+        NC_LOG_MESSAGE(line);
+    }
+}
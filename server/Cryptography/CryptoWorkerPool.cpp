@@ -0,0 +1,205 @@
+#include "CryptoWorkerPool.h"
+#include "SHA256.h"
+#include "SHA256MultiBuffer.h"
+#include "../EngineLoopGroup.h"
+#include "../Networking/ConnectionIdentity.h"
+#include "../Utils/EngineMessages.h"
+#include "../ECS/Components/Singletons/TimeSingleton.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <tracy/Tracy.hpp>
+
+CryptoWorkerPool::CryptoWorkerPool(EngineLoopGroup* engineLoopGroup, u32 workerCount, size_t maxQueuedJobs)
+    : _engineLoopGroup(engineLoopGroup), _maxQueuedJobs(maxQueuedJobs), _queuedJobCount(0), _isRunning(true)
+{
+    for (u32 i = 0; i < std::max(workerCount, 1u); i++)
+    {
+        _workers.emplace_back(&CryptoWorkerPool::WorkerRun, this);
+    }
+}
+
+void CryptoWorkerPool::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_jobMutex);
+        _isRunning = false;
+    }
+    _jobCondition.notify_all();
+
+    for (std::thread& worker : _workers)
+    {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+bool CryptoWorkerPool::TrySubmit(PasswordProofJob& job)
+{
+    job.submitTimeNS = TimeSingleton::Now();
+
+    std::lock_guard<std::mutex> lock(_jobMutex);
+    if (_queuedJobCount >= _maxQueuedJobs)
+        return false;
+
+    _pendingJobs.push_back(job);
+    _queuedJobCount++;
+    return true;
+}
+
+void CryptoWorkerPool::Flush()
+{
+    ZoneScopedNC("CryptoWorkerPool::Flush", tracy::Color::Purple)
+
+    size_t batchCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(_jobMutex);
+        for (size_t begin = 0; begin < _pendingJobs.size(); begin += MAX_BATCH_SIZE)
+        {
+            size_t end = std::min(begin + MAX_BATCH_SIZE, _pendingJobs.size());
+            _batches.emplace_back(_pendingJobs.begin() + begin, _pendingJobs.begin() + end);
+            batchCount++;
+        }
+        _pendingJobs.clear();
+    }
+
+    if (batchCount == 1)
+    {
+        _jobCondition.notify_one();
+    }
+    else if (batchCount > 1)
+    {
+        _jobCondition.notify_all();
+    }
+}
+
+void CryptoWorkerPool::RecordCompletion(const PasswordProofBatchResult& batchResult)
+{
+    RecordStage(CryptoStage::COMPLETION, TimeSingleton::Now() - batchResult.postTimeNS, batchResult.results.size());
+}
+
+CryptoStageStats CryptoWorkerPool::GetStageStats(CryptoStage stage) const
+{
+    const StageCounters& counters = _stageCounters[static_cast<size_t>(stage)];
+
+    CryptoStageStats stats;
+    stats.count = counters.count.load(std::memory_order_relaxed);
+    stats.totalNS = counters.totalNS.load(std::memory_order_relaxed);
+    stats.maxNS = counters.maxNS.load(std::memory_order_relaxed);
+    return stats;
+}
+
+size_t CryptoWorkerPool::GetQueuedJobCount()
+{
+    std::lock_guard<std::mutex> lock(_jobMutex);
+    return _queuedJobCount;
+}
+
+void CryptoWorkerPool::VerifyPasswordProofs(const std::vector<PasswordProofJob>& jobs, std::vector<PasswordProofResult>& results)
+{
+    // Every proof hashes the same 64 bytes, so the whole batch fills the multi-buffer lanes
+    thread_local std::vector<u8> messages;
+    thread_local std::vector<u8> digests;
+    thread_local std::vector<SHA256BatchEntry> entries;
+
+    constexpr size_t messageSize = sizeof(PasswordProofJob::serverNonce) + sizeof(PasswordProofJob::verifier);
+    messages.resize(jobs.size() * messageSize);
+    digests.resize(jobs.size() * SHA256::DIGEST_SIZE);
+    entries.resize(jobs.size());
+
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        u8* message = &messages[i * messageSize];
+        memcpy(message, jobs[i].serverNonce.data(), jobs[i].serverNonce.size());
+        memcpy(message + jobs[i].serverNonce.size(), jobs[i].verifier.data(), jobs[i].verifier.size());
+
+        entries[i].data = message;
+        entries[i].size = messageSize;
+        entries[i].digest = &digests[i * SHA256::DIGEST_SIZE];
+    }
+
+    SHA256MultiBuffer::HashBatch(entries.data(), entries.size());
+
+    results.resize(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        // Compare every byte so the time taken doesn't tell how much of the proof was right
+        u8 difference = 0;
+        for (size_t j = 0; j < SHA256::DIGEST_SIZE; j++)
+        {
+            difference |= entries[i].digest[j] ^ jobs[i].clientProof[j];
+        }
+
+        results[i].identity = jobs[i].identity;
+        results[i].verified = difference == 0;
+    }
+}
+
+void CryptoWorkerPool::WorkerRun()
+{
+    while (true)
+    {
+        std::vector<PasswordProofJob> batch;
+        {
+            std::unique_lock<std::mutex> lock(_jobMutex);
+            _jobCondition.wait(lock, [this]() { return !_isRunning || !_batches.empty(); });
+
+            if (!_isRunning)
+                break;
+
+            batch = std::move(_batches.front());
+            _batches.pop_front();
+            _queuedJobCount -= batch.size();
+        }
+
+        ZoneScopedNC("CryptoWorkerPool::VerifyPasswordProofs", tracy::Color::Purple)
+
+        u64 startTimeNS = TimeSingleton::Now();
+        for (const PasswordProofJob& job : batch)
+        {
+            RecordStage(CryptoStage::QUEUE, startTimeNS - job.submitTimeNS);
+        }
+
+        thread_local std::vector<PasswordProofResult> results;
+        VerifyPasswordProofs(batch, results);
+
+        u64 postTimeNS = TimeSingleton::Now();
+        RecordStage(CryptoStage::EXECUTE, postTimeNS - startTimeNS, batch.size());
+
+        // A batch mixes jobs of every shard, each shard gets one message with its own results
+        u32 shardCount = _engineLoopGroup->GetShardCount();
+        thread_local std::vector<PasswordProofBatchResult*> shardResults;
+        shardResults.assign(shardCount, nullptr);
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            PasswordProofBatchResult*& batchResult = shardResults[ConnectionIdentity::GetShardIndex(batch[i].identity)];
+            if (!batchResult)
+            {
+                batchResult = new PasswordProofBatchResult();
+                batchResult->postTimeNS = postTimeNS;
+            }
+
+            batchResult->results.push_back(results[i]);
+        }
+
+        for (u32 shardIndex = 0; shardIndex < shardCount; shardIndex++)
+        {
+            if (!shardResults[shardIndex])
+                continue;
+
+            _engineLoopGroup->GetShard(shardIndex).PassMessage(EngineInputMessage::CryptoResult(shardResults[shardIndex]));
+        }
+    }
+}
+
+void CryptoWorkerPool::RecordStage(CryptoStage stage, u64 durationNS, u64 count)
+{
+    // A batch counts once per job it contains, so totalNS / count stays the latency a single login sees
+    StageCounters& counters = _stageCounters[static_cast<size_t>(stage)];
+    counters.count.fetch_add(count, std::memory_order_relaxed);
+    counters.totalNS.fetch_add(durationNS * count, std::memory_order_relaxed);
+
+    u64 maxNS = counters.maxNS.load(std::memory_order_relaxed);
+    while (durationNS > maxNS && !counters.maxNS.compare_exchange_weak(maxNS, durationNS, std::memory_order_relaxed)) { }
+}
@@ -0,0 +1,130 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct PasswordProofJob
+{
+    u64 identity = 0; // ConnectionIdentity of the connection logging in
+    std::array<u8, 32> serverNonce = {};
+    std::array<u8, 32> verifier = {};
+    std::array<u8, 32> clientProof = {};
+    u64 submitTimeNS = 0;
+};
+
+struct PasswordProofResult
+{
+    u64 identity = 0;
+    bool verified = false;
+};
+
+// Posted back to the EngineLoop as an EngineInputType::CRYPTO_RESULT message, one per batch and shard
+struct PasswordProofBatchResult
+{
+    std::vector<PasswordProofResult> results;
+    u64 postTimeNS = 0;
+};
+
+enum class CryptoStage
+{
+    QUEUE, // TrySubmit until a worker picks the job up
+    EXECUTE, // Running the verification
+    COMPLETION, // Posted until the EngineLoop handled the result
+    COUNT
+};
+
+struct CryptoStageStats
+{
+    u64 count = 0;
+    u64 totalNS = 0;
+    u64 maxNS = 0;
+};
+
+class EngineLoopGroup;
+
+// Runs password verification off the taskflow workers so a burst of logins can't stall the packet systems.
+// The pool has its own threads and a bounded job queue, jobs submitted during a tick are grouped by Flush into batches
+// that a worker verifies with a single SHA256MultiBuffer::HashBatch call. Shared by every engine shard, results go back
+// to the shard that submitted the job through its EngineLoop::PassMessage.
+class CryptoWorkerPool
+{
+public:
+    CryptoWorkerPool(EngineLoopGroup* engineLoopGroup, u32 workerCount, size_t maxQueuedJobs);
+    ~CryptoWorkerPool() { Stop(); }
+
+    // Joins the workers, jobs they haven't picked up are dropped. Called once no engine shard submits anything anymore,
+    // the workers post their results to the shards
+    void Stop();
+
+    // Thread safe, returns false when the queue is full so the caller can retry later
+    bool TrySubmit(PasswordProofJob& job);
+
+    // Called by the engine threads once per tick
+    void Flush();
+
+    // Called by the EngineLoop when it handles a batch result
+    void RecordCompletion(const PasswordProofBatchResult& batchResult);
+
+    CryptoStageStats GetStageStats(CryptoStage stage) const;
+    size_t GetQueuedJobCount();
+
+    // The client proves it knows the account's verifier with SHA256(serverNonce | verifier), the nonce is new for every
+    // handshake so a captured proof can't be replayed. The verifier itself still logs in anyone who reads it from the account
+    // backend, @TODO: Replace this with SRP6 so the backend only holds what can't be used to log in
+    static void VerifyPasswordProofs(const std::vector<PasswordProofJob>& jobs, std::vector<PasswordProofResult>& results);
+
+    static constexpr size_t MAX_BATCH_SIZE = 256;
+
+private:
+    struct StageCounters
+    {
+        std::atomic<u64> count = 0;
+        std::atomic<u64> totalNS = 0;
+        std::atomic<u64> maxNS = 0;
+    };
+
+    void WorkerRun();
+    void RecordStage(CryptoStage stage, u64 durationNS, u64 count = 1);
+
+private:
+    EngineLoopGroup* _engineLoopGroup;
+    size_t _maxQueuedJobs;
+
+    std::mutex _jobMutex;
+    std::condition_variable _jobCondition;
+    std::vector<PasswordProofJob> _pendingJobs;
+    std::deque<std::vector<PasswordProofJob>> _batches;
+    size_t _queuedJobCount;
+    bool _isRunning;
+
+    std::vector<std::thread> _workers;
+    StageCounters _stageCounters[static_cast<size_t>(CryptoStage::COUNT)];
+};
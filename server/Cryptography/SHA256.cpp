@@ -0,0 +1,124 @@
+#include "SHA256.h"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    inline u32 RotateRight(u32 value, u32 count)
+    {
+        return (value >> count) | (value << (32 - count));
+    }
+
+    inline u32 LoadBigEndian(const u8* data)
+    {
+        return (static_cast<u32>(data[0]) << 24) | (static_cast<u32>(data[1]) << 16) | (static_cast<u32>(data[2]) << 8) | static_cast<u32>(data[3]);
+    }
+}
+
+SHA256::SHA256()
+    : _length(0), _bufferSize(0)
+{
+    memcpy(_state, INITIAL_STATE, sizeof(_state));
+}
+
+void SHA256::Update(const void* data, size_t size)
+{
+    const u8* bytes = static_cast<const u8*>(data);
+    _length += size;
+
+    if (_bufferSize > 0)
+    {
+        size_t toCopy = std::min(size, BLOCK_SIZE - _bufferSize);
+        memcpy(_buffer + _bufferSize, bytes, toCopy);
+        _bufferSize += toCopy;
+        bytes += toCopy;
+        size -= toCopy;
+
+        if (_bufferSize < BLOCK_SIZE)
+            return;
+
+        Transform(_state, _buffer, 1);
+        _bufferSize = 0;
+    }
+
+    size_t blockCount = size / BLOCK_SIZE;
+    if (blockCount > 0)
+    {
+        Transform(_state, bytes, blockCount);
+        bytes += blockCount * BLOCK_SIZE;
+        size -= blockCount * BLOCK_SIZE;
+    }
+
+    memcpy(_buffer, bytes, size);
+    _bufferSize = size;
+}
+
+void SHA256::Final(u8 (&digest)[DIGEST_SIZE])
+{
+    u64 bitLength = _length * 8;
+
+    u8 padding[BLOCK_SIZE * 2] = { 0x80 };
+    size_t paddingSize = (_bufferSize < 56 ? 56 : 120) - _bufferSize;
+    for (i32 i = 0; i < 8; i++)
+    {
+        padding[paddingSize + i] = static_cast<u8>(bitLength >> (56 - i * 8));
+    }
+    Update(padding, paddingSize + 8);
+
+    for (i32 i = 0; i < 8; i++)
+    {
+        digest[i * 4 + 0] = static_cast<u8>(_state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<u8>(_state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<u8>(_state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<u8>(_state[i]);
+    }
+}
+
+void SHA256::Hash(const void* data, size_t size, u8 (&digest)[DIGEST_SIZE])
+{
+    SHA256 sha;
+    sha.Update(data, size);
+    sha.Final(digest);
+}
+
+void SHA256::Transform(u32 (&state)[8], const u8* blocks, size_t blockCount)
+{
+    for (size_t block = 0; block < blockCount; block++, blocks += BLOCK_SIZE)
+    {
+        u32 w[64];
+        for (i32 i = 0; i < 16; i++)
+        {
+            w[i] = LoadBigEndian(blocks + i * 4);
+        }
+        for (i32 i = 16; i < 64; i++)
+        {
+            u32 s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            u32 s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        u32 a = state[0], b = state[1], c = state[2], d = state[3];
+        u32 e = state[4], f = state[5], g = state[6], h = state[7];
+        for (i32 i = 0; i < 64; i++)
+        {
+            u32 s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+            u32 choice = (e & f) ^ (~e & g);
+            u32 temp1 = h + s1 + choice + ROUND_CONSTANTS[i] + w[i];
+            u32 s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+            u32 majority = (a & b) ^ (a & c) ^ (b & c);
+            u32 temp2 = s0 + majority;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
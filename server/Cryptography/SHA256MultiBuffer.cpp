@@ -0,0 +1,233 @@
+#include "SHA256MultiBuffer.h"
+#include "SHA256.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace
+{
+    void TransformScalar(u32* states, const u8* const* messages, size_t blockCount)
+    {
+        // With a single lane the [word][lane] layout is just the regular state
+        SHA256::Transform(*reinterpret_cast<u32(*)[8]>(states), messages[0], blockCount);
+    }
+
+    const SHA256LaneKernel scalarKernel = { "Scalar", 1, &TransformScalar };
+
+    bool CPUSupportsAVX2()
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        i32 registers[4];
+        __cpuid(registers, 1);
+        bool osSavesYMM = (registers[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+
+        __cpuidex(registers, 7, 0);
+        return osSavesYMM && (registers[1] & (1 << 5));
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    bool CPUSupportsAVX512()
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        i32 registers[4];
+        __cpuid(registers, 1);
+        bool osSavesZMM = (registers[2] & (1 << 27)) && (_xgetbv(0) & 0xE6) == 0xE6;
+
+        __cpuidex(registers, 7, 0);
+        return osSavesZMM && (registers[1] & (1 << 16));
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f");
+#else
+        return false;
+#endif
+    }
+
+    struct KernelSet
+    {
+        // Widest first, always ends with the scalar kernel
+        const SHA256LaneKernel* kernels[4];
+        u32 count = 0;
+    };
+
+    const KernelSet& GetAvailableKernels()
+    {
+        static const KernelSet kernelSet = []()
+        {
+            KernelSet set;
+
+            const SHA256LaneKernel* avx512 = GetSHA256KernelAVX512();
+            if (avx512 && CPUSupportsAVX512())
+                set.kernels[set.count++] = avx512;
+
+            const SHA256LaneKernel* avx2 = GetSHA256KernelAVX2();
+            if (avx2 && CPUSupportsAVX2())
+                set.kernels[set.count++] = avx2;
+
+            if (const SHA256LaneKernel* sse2 = GetSHA256KernelSSE2())
+                set.kernels[set.count++] = sse2;
+
+            set.kernels[set.count++] = &scalarKernel;
+            return set;
+        }();
+
+        return kernelSet;
+    }
+
+    std::atomic<u32> maxLaneCount = 16;
+
+    size_t GetPaddedBlockCount(size_t size)
+    {
+        // Message, the 0x80 terminator and the 64 bit length, rounded up to whole blocks
+        return (size + 9 + SHA256::BLOCK_SIZE - 1) / SHA256::BLOCK_SIZE;
+    }
+
+    void RunKernel(const SHA256LaneKernel& kernel, const SHA256BatchEntry* entries, const u32* indices, const u8* const* messages, size_t blockCount)
+    {
+        constexpr u32 MAX_LANES = 16;
+        alignas(64) u32 states[8 * MAX_LANES];
+
+        u32 laneCount = kernel.laneCount;
+        for (u32 word = 0; word < 8; word++)
+        {
+            for (u32 lane = 0; lane < laneCount; lane++)
+            {
+                states[word * laneCount + lane] = SHA256::INITIAL_STATE[word];
+            }
+        }
+
+        kernel.transform(states, messages, blockCount);
+
+        for (u32 lane = 0; lane < laneCount; lane++)
+        {
+            u8* digest = entries[indices[lane]].digest;
+            for (u32 word = 0; word < 8; word++)
+            {
+                u32 value = states[word * laneCount + lane];
+                digest[word * 4 + 0] = static_cast<u8>(value >> 24);
+                digest[word * 4 + 1] = static_cast<u8>(value >> 16);
+                digest[word * 4 + 2] = static_cast<u8>(value >> 8);
+                digest[word * 4 + 3] = static_cast<u8>(value);
+            }
+        }
+    }
+}
+
+void SHA256MultiBuffer::HashBatch(const SHA256BatchEntry* entries, size_t count)
+{
+    // Kept per thread so hashing a batch doesn't allocate once the buffers have grown
+    thread_local std::vector<u8> paddedData;
+    thread_local std::vector<size_t> paddedOffsets;
+    thread_local std::vector<u32> order;
+
+    paddedOffsets.resize(count);
+    order.resize(count);
+
+    size_t paddedSize = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        paddedOffsets[i] = paddedSize;
+        paddedSize += GetPaddedBlockCount(entries[i].size) * SHA256::BLOCK_SIZE;
+        order[i] = static_cast<u32>(i);
+    }
+
+    paddedData.resize(paddedSize);
+    for (size_t i = 0; i < count; i++)
+    {
+        u8* padded = paddedData.data() + paddedOffsets[i];
+        size_t blockBytes = GetPaddedBlockCount(entries[i].size) * SHA256::BLOCK_SIZE;
+
+        memcpy(padded, entries[i].data, entries[i].size);
+        memset(padded + entries[i].size, 0, blockBytes - entries[i].size);
+        padded[entries[i].size] = 0x80;
+
+        u64 bitLength = static_cast<u64>(entries[i].size) * 8;
+        for (i32 byte = 0; byte < 8; byte++)
+        {
+            padded[blockBytes - 1 - byte] = static_cast<u8>(bitLength >> (byte * 8));
+        }
+    }
+
+    // Group messages with the same block count, those can share lanes
+    std::stable_sort(order.begin(), order.end(), [entries](u32 a, u32 b)
+    {
+        return GetPaddedBlockCount(entries[a].size) < GetPaddedBlockCount(entries[b].size);
+    });
+
+    const KernelSet& kernelSet = GetAvailableKernels();
+    u32 laneLimit = maxLaneCount.load(std::memory_order_relaxed);
+
+    size_t groupBegin = 0;
+    while (groupBegin < count)
+    {
+        size_t blockCount = GetPaddedBlockCount(entries[order[groupBegin]].size);
+        size_t groupEnd = groupBegin + 1;
+        while (groupEnd < count && GetPaddedBlockCount(entries[order[groupEnd]].size) == blockCount)
+        {
+            groupEnd++;
+        }
+
+        size_t position = groupBegin;
+        for (u32 i = 0; i < kernelSet.count; i++)
+        {
+            const SHA256LaneKernel& kernel = *kernelSet.kernels[i];
+            if (kernel.laneCount > laneLimit && kernel.laneCount > 1)
+                continue;
+
+            while (groupEnd - position >= kernel.laneCount)
+            {
+                const u8* messages[16];
+                for (u32 lane = 0; lane < kernel.laneCount; lane++)
+                {
+                    messages[lane] = paddedData.data() + paddedOffsets[order[position + lane]];
+                }
+
+                RunKernel(kernel, entries, &order[position], messages, blockCount);
+                position += kernel.laneCount;
+            }
+        }
+
+        groupBegin = groupEnd;
+    }
+}
+
+const char* SHA256MultiBuffer::GetKernelName()
+{
+    const KernelSet& kernelSet = GetAvailableKernels();
+    u32 laneLimit = maxLaneCount.load(std::memory_order_relaxed);
+    for (u32 i = 0; i < kernelSet.count; i++)
+    {
+        if (kernelSet.kernels[i]->laneCount <= laneLimit)
+            return kernelSet.kernels[i]->name;
+    }
+
+    return scalarKernel.name;
+}
+
+u32 SHA256MultiBuffer::GetLaneCount()
+{
+    const KernelSet& kernelSet = GetAvailableKernels();
+    u32 laneLimit = maxLaneCount.load(std::memory_order_relaxed);
+    for (u32 i = 0; i < kernelSet.count; i++)
+    {
+        if (kernelSet.kernels[i]->laneCount <= laneLimit)
+            return kernelSet.kernels[i]->laneCount;
+    }
+
+    return 1;
+}
+
+void SHA256MultiBuffer::SetMaxLaneCount(u32 laneCount)
+{
+    maxLaneCount.store(std::max(laneCount, 1u), std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+
+struct SHA256BatchEntry
+{
+    const void* data = nullptr;
+    size_t size = 0;
+    u8* digest = nullptr; // SHA256::DIGEST_SIZE bytes
+};
+
+// Runs the SHA256 compression function over 4, 8 or 16 independent messages at once (SSE2, AVX2, AVX-512).
+// The widest kernel the CPU supports is picked at runtime, messages that don't fill a kernel fall through to narrower ones and finally the scalar SHA256.
+class SHA256MultiBuffer
+{
+public:
+    // Messages needing the same number of blocks share lanes, a batch of equally sized messages (like auth proofs) gets the most out of this
+    static void HashBatch(const SHA256BatchEntry* entries, size_t count);
+
+    static const char* GetKernelName();
+    static u32 GetLaneCount();
+
+    // Skip SIMD kernels wider than laneCount, 1 forces the scalar path. Used to compare kernels against each other
+    static void SetMaxLaneCount(u32 laneCount);
+};
+
+// Transforms blockCount blocks of LANES messages, states holds the 8 state words of every lane word by word ([word][lane])
+typedef void (*SHA256LaneTransformFn)(u32* states, const u8* const* messages, size_t blockCount);
+
+struct SHA256LaneKernel
+{
+    const char* name;
+    u32 laneCount;
+    SHA256LaneTransformFn transform;
+};
+
+// Each returns nullptr when its translation unit was built without the instruction set it needs
+const SHA256LaneKernel* GetSHA256KernelSSE2();
+const SHA256LaneKernel* GetSHA256KernelAVX2();
+const SHA256LaneKernel* GetSHA256KernelAVX512();
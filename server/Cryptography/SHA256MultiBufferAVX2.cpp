@@ -0,0 +1,43 @@
+#include "SHA256MultiBuffer.h"
+
+// Built with -mavx2 (/arch:AVX2), only called after SHA256MultiBuffer checked that the CPU supports it
+#if defined(__AVX2__)
+#include "SHA256MultiBufferKernel.h"
+#include <immintrin.h>
+
+namespace
+{
+    struct AVX2Ops
+    {
+        typedef __m256i Vector;
+        static constexpr u32 LANES = 8;
+
+        static Vector Load(const u32* data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)); }
+        static void Store(u32* data, Vector value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), value); }
+        static Vector Set1(u32 value) { return _mm256_set1_epi32(static_cast<i32>(value)); }
+
+        static Vector Add(Vector a, Vector b) { return _mm256_add_epi32(a, b); }
+        static Vector Xor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+        static Vector And(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+        static Vector AndNot(Vector a, Vector b) { return _mm256_andnot_si256(a, b); } // ~a & b
+        static Vector Or(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+
+        template <i32 Count>
+        static Vector Shr(Vector a) { return _mm256_srli_epi32(a, Count); }
+        template <i32 Count>
+        static Vector Ror(Vector a) { return _mm256_or_si256(_mm256_srli_epi32(a, Count), _mm256_slli_epi32(a, 32 - Count)); }
+    };
+
+    const SHA256LaneKernel kernel = { "AVX2", AVX2Ops::LANES, &SHA256TransformLanes<AVX2Ops> };
+}
+
+const SHA256LaneKernel* GetSHA256KernelAVX2()
+{
+    return &kernel;
+}
+#else
+const SHA256LaneKernel* GetSHA256KernelAVX2()
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,45 @@
+#include "SHA256MultiBuffer.h"
+
+// Built with -mavx512f (/arch:AVX512), only called after SHA256MultiBuffer checked that the CPU supports it
+#if defined(__AVX512F__)
+#include "SHA256MultiBufferKernel.h"
+#include <immintrin.h>
+
+namespace
+{
+    struct AVX512Ops
+    {
+        typedef __m512i Vector;
+        static constexpr u32 LANES = 16;
+
+        static Vector Load(const u32* data) { return _mm512_loadu_si512(data); }
+        static void Store(u32* data, Vector value) { _mm512_storeu_si512(data, value); }
+        static Vector Set1(u32 value) { return _mm512_set1_epi32(static_cast<i32>(value)); }
+
+        static Vector Add(Vector a, Vector b) { return _mm512_add_epi32(a, b); }
+        static Vector Xor(Vector a, Vector b) { return _mm512_xor_si512(a, b); }
+        static Vector And(Vector a, Vector b) { return _mm512_and_si512(a, b); }
+        static Vector Or(Vector a, Vector b) { return _mm512_or_si512(a, b); }
+
+        // The unmasked andnot, shift and rotate pass _mm512_undefined_epi32() as their merge source, which GCC 12 reports as
+        // -Wmaybe-uninitialized once inlined. With every lane selected the zero-masked forms compute the same thing
+        static Vector AndNot(Vector a, Vector b) { return _mm512_maskz_andnot_epi32(0xFFFF, a, b); } // ~a & b
+        template <i32 Count>
+        static Vector Shr(Vector a) { return _mm512_maskz_srli_epi32(0xFFFF, a, Count); }
+        template <i32 Count>
+        static Vector Ror(Vector a) { return _mm512_maskz_ror_epi32(0xFFFF, a, Count); }
+    };
+
+    const SHA256LaneKernel kernel = { "AVX-512", AVX512Ops::LANES, &SHA256TransformLanes<AVX512Ops> };
+}
+
+const SHA256LaneKernel* GetSHA256KernelAVX512()
+{
+    return &kernel;
+}
+#else
+const SHA256LaneKernel* GetSHA256KernelAVX512()
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+#include <NovusTypes.h>
+#include "SHA256.h"
+
+// Shared body of the multi-buffer kernels, every SHA256MultiBuffer<ISA>.cpp instantiates it with its own Ops
+// so the whole kernel gets compiled for that instruction set.
+template <typename Ops>
+void SHA256TransformLanes(u32* states, const u8* const* messages, size_t blockCount)
+{
+    typedef typename Ops::Vector Vector;
+    constexpr u32 LANES = Ops::LANES;
+
+    Vector state[8];
+    for (i32 i = 0; i < 8; i++)
+    {
+        state[i] = Ops::Load(states + i * LANES);
+    }
+
+    for (size_t block = 0; block < blockCount; block++)
+    {
+        // Transpose the lanes' big endian words so word i of every lane ends up in one vector
+        alignas(64) u32 words[16][LANES];
+        for (u32 lane = 0; lane < LANES; lane++)
+        {
+            const u8* data = messages[lane] + block * SHA256::BLOCK_SIZE;
+            for (i32 i = 0; i < 16; i++)
+            {
+                words[i][lane] = (static_cast<u32>(data[i * 4]) << 24) | (static_cast<u32>(data[i * 4 + 1]) << 16) | (static_cast<u32>(data[i * 4 + 2]) << 8) | static_cast<u32>(data[i * 4 + 3]);
+            }
+        }
+
+        Vector w[16];
+        for (i32 i = 0; i < 16; i++)
+        {
+            w[i] = Ops::Load(words[i]);
+        }
+
+        Vector a = state[0], b = state[1], c = state[2], d = state[3];
+        Vector e = state[4], f = state[5], g = state[6], h = state[7];
+        for (i32 i = 0; i < 64; i++)
+        {
+            if (i >= 16)
+            {
+                Vector w15 = w[(i - 15) & 15];
+                Vector w2 = w[(i - 2) & 15];
+                Vector s0 = Ops::Xor(Ops::Xor(Ops::template Ror<7>(w15), Ops::template Ror<18>(w15)), Ops::template Shr<3>(w15));
+                Vector s1 = Ops::Xor(Ops::Xor(Ops::template Ror<17>(w2), Ops::template Ror<19>(w2)), Ops::template Shr<10>(w2));
+                w[i & 15] = Ops::Add(Ops::Add(w[i & 15], s0), Ops::Add(w[(i - 7) & 15], s1));
+            }
+
+            Vector s1 = Ops::Xor(Ops::Xor(Ops::template Ror<6>(e), Ops::template Ror<11>(e)), Ops::template Ror<25>(e));
+            Vector choice = Ops::Xor(Ops::And(e, f), Ops::AndNot(e, g));
+            Vector temp1 = Ops::Add(Ops::Add(h, s1), Ops::Add(Ops::Add(choice, Ops::Set1(SHA256::ROUND_CONSTANTS[i])), w[i & 15]));
+            Vector s0 = Ops::Xor(Ops::Xor(Ops::template Ror<2>(a), Ops::template Ror<13>(a)), Ops::template Ror<22>(a));
+            Vector majority = Ops::Or(Ops::And(a, b), Ops::And(c, Ops::Or(a, b)));
+            Vector temp2 = Ops::Add(s0, majority);
+
+            h = g;
+            g = f;
+            f = e;
+            e = Ops::Add(d, temp1);
+            d = c;
+            c = b;
+            b = a;
+            a = Ops::Add(temp1, temp2);
+        }
+
+        state[0] = Ops::Add(state[0], a); state[1] = Ops::Add(state[1], b);
+        state[2] = Ops::Add(state[2], c); state[3] = Ops::Add(state[3], d);
+        state[4] = Ops::Add(state[4], e); state[5] = Ops::Add(state[5], f);
+        state[6] = Ops::Add(state[6], g); state[7] = Ops::Add(state[7], h);
+    }
+
+    for (i32 i = 0; i < 8; i++)
+    {
+        Ops::Store(states + i * LANES, state[i]);
+    }
+}
@@ -0,0 +1,42 @@
+#include "SHA256MultiBuffer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include "SHA256MultiBufferKernel.h"
+#include <emmintrin.h>
+
+namespace
+{
+    struct SSE2Ops
+    {
+        typedef __m128i Vector;
+        static constexpr u32 LANES = 4;
+
+        static Vector Load(const u32* data) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)); }
+        static void Store(u32* data, Vector value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(data), value); }
+        static Vector Set1(u32 value) { return _mm_set1_epi32(static_cast<i32>(value)); }
+
+        static Vector Add(Vector a, Vector b) { return _mm_add_epi32(a, b); }
+        static Vector Xor(Vector a, Vector b) { return _mm_xor_si128(a, b); }
+        static Vector And(Vector a, Vector b) { return _mm_and_si128(a, b); }
+        static Vector AndNot(Vector a, Vector b) { return _mm_andnot_si128(a, b); } // ~a & b
+        static Vector Or(Vector a, Vector b) { return _mm_or_si128(a, b); }
+
+        template <i32 Count>
+        static Vector Shr(Vector a) { return _mm_srli_epi32(a, Count); }
+        template <i32 Count>
+        static Vector Ror(Vector a) { return _mm_or_si128(_mm_srli_epi32(a, Count), _mm_slli_epi32(a, 32 - Count)); }
+    };
+
+    const SHA256LaneKernel kernel = { "SSE2", SSE2Ops::LANES, &SHA256TransformLanes<SSE2Ops> };
+}
+
+const SHA256LaneKernel* GetSHA256KernelSSE2()
+{
+    return &kernel;
+}
+#else
+const SHA256LaneKernel* GetSHA256KernelSSE2()
+{
+    return nullptr;
+}
+#endif
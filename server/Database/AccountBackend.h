@@ -0,0 +1,46 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <array>
+#include <string>
+#include <vector>
+
+struct AccountRecord
+{
+    u32 id = 0;
+    std::string name;
+    std::array<u8, 32> salt = {};
+    std::array<u8, 32> verifier = {};
+};
+
+// Storage the AccountQueryService runs its batches against, called from several query workers at once so implementations must be thread safe
+class AccountBackend
+{
+public:
+    virtual ~AccountBackend() { }
+
+    // Looks up every name in one round trip, names that do not exist are left out of foundRecords
+    virtual void LookupByNames(const std::vector<std::string>& names, std::vector<AccountRecord>& foundRecords) = 0;
+};
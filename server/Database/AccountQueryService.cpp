@@ -0,0 +1,139 @@
+#include "AccountQueryService.h"
+#include "../Networking/ConnectionIdentity.h"
+#include <algorithm>
+#include <unordered_map>
+#include <tracy/Tracy.hpp>
+
+AccountQueryService::AccountQueryService(std::unique_ptr<AccountBackend> backend, u32 workerCount, u32 shardCount)
+    : _backend(std::move(backend)), _pendingQueries(256), _isRunning(true)
+{
+    for (u32 i = 0; i < std::max(shardCount, 1u); i++)
+    {
+        _results.push_back(std::make_unique<moodycamel::ConcurrentQueue<AccountQueryResult>>(256));
+    }
+
+    for (u32 i = 0; i < std::max(workerCount, 1u); i++)
+    {
+        _workers.emplace_back(&AccountQueryService::WorkerRun, this);
+    }
+}
+
+void AccountQueryService::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_batchMutex);
+        _isRunning = false;
+    }
+    _batchCondition.notify_all();
+
+    for (std::thread& worker : _workers)
+    {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+void AccountQueryService::LookupAccountByName(u64 identity, const std::string& accountName)
+{
+    AccountQuery query;
+    query.identity = identity;
+    query.accountName = accountName;
+    _pendingQueries.enqueue(std::move(query));
+}
+
+void AccountQueryService::Flush()
+{
+    ZoneScopedNC("AccountQueryService::Flush", tracy::Color::Yellow2)
+
+    std::vector<AccountQuery> batch;
+    batch.resize(MAX_BATCH_SIZE);
+
+    size_t batchSize;
+    u32 batchCount = 0;
+    while ((batchSize = _pendingQueries.try_dequeue_bulk(batch.begin(), MAX_BATCH_SIZE)) > 0)
+    {
+        batch.resize(batchSize);
+        {
+            std::lock_guard<std::mutex> lock(_batchMutex);
+            _batches.push_back(std::move(batch));
+        }
+        batchCount++;
+
+        batch.clear();
+        batch.resize(MAX_BATCH_SIZE);
+    }
+
+    if (batchCount == 1)
+    {
+        _batchCondition.notify_one();
+    }
+    else if (batchCount > 1)
+    {
+        _batchCondition.notify_all();
+    }
+}
+
+bool AccountQueryService::TryGetResult(u32 shardIndex, AccountQueryResult& result)
+{
+    return _results[shardIndex]->try_dequeue(result);
+}
+
+void AccountQueryService::WorkerRun()
+{
+    while (true)
+    {
+        std::vector<AccountQuery> batch;
+        {
+            std::unique_lock<std::mutex> lock(_batchMutex);
+            _batchCondition.wait(lock, [this]() { return !_isRunning || !_batches.empty(); });
+
+            if (!_isRunning)
+                break;
+
+            batch = std::move(_batches.front());
+            _batches.pop_front();
+        }
+
+        RunBatch(batch);
+    }
+}
+
+void AccountQueryService::RunBatch(std::vector<AccountQuery>& batch)
+{
+    ZoneScopedNC("AccountQueryService::RunBatch", tracy::Color::Yellow2)
+
+    // Several connections can ask for the same account (reconnects, credential stuffing), only look each name up once
+    std::unordered_map<std::string, const AccountRecord*> recordsByName;
+    std::vector<std::string> names;
+    names.reserve(batch.size());
+    for (const AccountQuery& query : batch)
+    {
+        if (recordsByName.emplace(query.accountName, nullptr).second)
+        {
+            names.push_back(query.accountName);
+        }
+    }
+
+    std::vector<AccountRecord> foundRecords;
+    foundRecords.reserve(names.size());
+    _backend->LookupByNames(names, foundRecords);
+
+    for (const AccountRecord& record : foundRecords)
+    {
+        recordsByName[record.name] = &record;
+    }
+
+    for (AccountQuery& query : batch)
+    {
+        AccountQueryResult result;
+        result.identity = query.identity;
+
+        if (const AccountRecord* record = recordsByName[query.accountName])
+        {
+            result.found = true;
+            result.record = *record;
+        }
+
+        _results[ConnectionIdentity::GetShardIndex(query.identity)]->enqueue(std::move(result));
+    }
+}
@@ -0,0 +1,86 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Utils/ConcurrentQueue.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "AccountBackend.h"
+
+struct AccountQuery
+{
+    u64 identity = 0; // ConnectionIdentity of the connection that asked
+    std::string accountName;
+};
+
+struct AccountQueryResult
+{
+    u64 identity = 0;
+    bool found = false;
+    AccountRecord record;
+};
+
+// Runs account lookups on its own worker threads so handlers never block on the backend.
+// Lookups submitted during a tick are grouped by Flush into batches of up to MAX_BATCH_SIZE names, every batch is a single backend call.
+// Shared by every engine shard, results come back to the shard that asked.
+class AccountQueryService
+{
+public:
+    AccountQueryService(std::unique_ptr<AccountBackend> backend, u32 workerCount, u32 shardCount);
+    ~AccountQueryService() { Stop(); }
+
+    // Joins the workers, batches they haven't picked up are dropped. Called once no engine shard looks anything up anymore
+    void Stop();
+
+    // Thread safe, the result comes back through TryGetResult of the shard that owns the connection
+    void LookupAccountByName(u64 identity, const std::string& accountName);
+
+    // Called by the engine threads once per tick
+    void Flush();
+    bool TryGetResult(u32 shardIndex, AccountQueryResult& result);
+
+    AccountBackend* GetBackend() { return _backend.get(); }
+
+    static constexpr size_t MAX_BATCH_SIZE = 256;
+
+private:
+    void WorkerRun();
+    void RunBatch(std::vector<AccountQuery>& batch);
+
+private:
+    std::unique_ptr<AccountBackend> _backend;
+
+    moodycamel::ConcurrentQueue<AccountQuery> _pendingQueries;
+    std::vector<std::unique_ptr<moodycamel::ConcurrentQueue<AccountQueryResult>>> _results; // One per shard
+
+    std::mutex _batchMutex;
+    std::condition_variable _batchCondition;
+    std::deque<std::vector<AccountQuery>> _batches;
+    bool _isRunning;
+
+    std::vector<std::thread> _workers;
+};
@@ -0,0 +1,79 @@
+#include "InMemoryAccountBackend.h"
+#include "../Utils/AsyncLogger.h"
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace
+{
+    bool ParseHex(const char* text, std::array<u8, 32>& bytes)
+    {
+        if (strlen(text) != bytes.size() * 2)
+            return false;
+
+        for (size_t i = 0; i < bytes.size(); i++)
+        {
+            u32 value = 0;
+            if (sscanf(&text[i * 2], "%2x", &value) != 1)
+                return false;
+
+            bytes[i] = static_cast<u8>(value);
+        }
+
+        return true;
+    }
+}
+
+void InMemoryAccountBackend::AddAccount(const AccountRecord& record)
+{
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    _accounts.insert_or_assign(record.name, record);
+}
+
+void InMemoryAccountBackend::LookupByNames(const std::vector<std::string>& names, std::vector<AccountRecord>& foundRecords)
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    for (const std::string& name : names)
+    {
+        auto account = _accounts.find(name);
+        if (account != _accounts.end())
+        {
+            foundRecords.push_back(account->second);
+        }
+    }
+}
+
+bool InMemoryAccountBackend::LoadFromFile(const std::string& path, u32& loadedCount)
+{
+    loadedCount = 0;
+
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file)
+        return false;
+
+    char line[512];
+    u32 lineNumber = 0;
+    while (std::fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' || line[0] == '\0')
+            continue;
+
+        char name[256];
+        char salt[128];
+        char verifier[128];
+        AccountRecord record;
+        if (sscanf(line, "%u %255s %127s %127s", &record.id, name, salt, verifier) != 4 || !ParseHex(salt, record.salt) || !ParseHex(verifier, record.verifier))
+        {
+            NC_ASYNC_LOG_WARNING("Skipped malformed account on line %u of the accounts file", lineNumber);
+            continue;
+        }
+
+        record.name = name;
+        AddAccount(record);
+        loadedCount++;
+    }
+
+    std::fclose(file);
+    return true;
+}
@@ -0,0 +1,43 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include "AccountBackend.h"
+#include <shared_mutex>
+#include <unordered_map>
+
+// Keeps every account in memory, for running the server and its tools without a database
+class InMemoryAccountBackend : public AccountBackend
+{
+public:
+    void AddAccount(const AccountRecord& record);
+
+    // One account per line: id, name, salt and verifier, separated by spaces with the salt and verifier as 64 hex digits each.
+    // Empty lines and lines starting with # are skipped. Returns false if the file can't be opened, malformed lines are logged and skipped
+    bool LoadFromFile(const std::string& path, u32& loadedCount);
+    void LookupByNames(const std::vector<std::string>& names, std::vector<AccountRecord>& foundRecords) override;
+
+private:
+    std::shared_mutex _mutex;
+    std::unordered_map<std::string, AccountRecord> _accounts;
+};
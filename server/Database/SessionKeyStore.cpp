@@ -0,0 +1,185 @@
+#include "SessionKeyStore.h"
+#include <algorithm>
+#include <cstring>
+
+SessionKeyStore::SessionKeyStore(u32 capacity)
+{
+    u32 shardSize = 1;
+    while (shardSize * SHARD_COUNT < capacity || shardSize < MAX_PROBE_LENGTH)
+    {
+        shardSize <<= 1;
+    }
+
+    for (Shard& shard : _shards)
+    {
+        shard.entries = std::make_unique<Entry[]>(shardSize);
+    }
+
+    _shardSize = shardSize;
+    _shardMask = shardSize - 1;
+}
+
+void SessionKeyStore::Insert(u32 accountId, const SessionKey& sessionKey, u64 expiresAtNS, u64 nowNS)
+{
+    if (accountId == 0)
+        return;
+
+    u64 key[SESSION_KEY_SIZE / sizeof(u64)];
+    memcpy(key, sessionKey.data(), SESSION_KEY_SIZE);
+
+    u32 hash = Hash(accountId);
+    Shard& shard = _shards[hash % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+
+    // Writers are serialized by the shard lock, so reading the entries without the sequence check is safe here
+    Entry* victim = nullptr;
+    u64 victimExpiresAtNS = ~0ull;
+    for (u32 i = 0; i < MAX_PROBE_LENGTH; i++)
+    {
+        Entry& entry = shard.entries[(hash / SHARD_COUNT + i) & _shardMask];
+        u32 entryAccountId = entry.accountId.load(std::memory_order_relaxed);
+
+        if (entryAccountId == accountId)
+        {
+            victim = &entry;
+            break;
+        }
+
+        // Nothing is stored past the first slot that was never used
+        if (entryAccountId == 0)
+        {
+            if (!victim || victimExpiresAtNS > nowNS)
+                victim = &entry;
+            break;
+        }
+
+        u64 entryExpiresAtNS = entry.expiresAtNS.load(std::memory_order_relaxed);
+        if (!victim || entryExpiresAtNS < victimExpiresAtNS)
+        {
+            victim = &entry;
+            victimExpiresAtNS = entryExpiresAtNS;
+        }
+    }
+
+    Write(*victim, accountId, expiresAtNS, key);
+}
+
+bool SessionKeyStore::RemoveIfMatches(u32 accountId, const SessionKey& sessionKey)
+{
+    u32 hash = Hash(accountId);
+    Shard& shard = _shards[hash % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+
+    // Compared under the lock, an Insert for the account can't land between the check and the removal
+    EntrySnapshot snapshot;
+    u32 slot = FindSlot(shard, hash, accountId, snapshot);
+    if (slot == MAX_PROBE_LENGTH || memcmp(snapshot.sessionKey, sessionKey.data(), SESSION_KEY_SIZE) != 0)
+        return false;
+
+    // Keep the account id so the slot doesn't end the probe sequence of the entries behind it
+    u64 emptyKey[SESSION_KEY_SIZE / sizeof(u64)] = {};
+    Write(shard.entries[(hash / SHARD_COUNT + slot) & _shardMask], accountId, 0, emptyKey);
+    return true;
+}
+
+bool SessionKeyStore::Find(u32 accountId, u64 nowNS, SessionKey& sessionKey) const
+{
+    u32 hash = Hash(accountId);
+    const Shard& shard = _shards[hash % SHARD_COUNT];
+
+    EntrySnapshot snapshot;
+    if (FindSlot(shard, hash, accountId, snapshot) == MAX_PROBE_LENGTH || snapshot.expiresAtNS <= nowNS)
+        return false;
+
+    memcpy(sessionKey.data(), snapshot.sessionKey, SESSION_KEY_SIZE);
+    return true;
+}
+
+bool SessionKeyStore::Validate(u32 accountId, const SessionKey& sessionKey, u64 nowNS) const
+{
+    SessionKey storedKey;
+    if (!Find(accountId, nowNS, storedKey))
+        return false;
+
+    // Compare every byte so the time taken doesn't tell how much of a guessed key was right
+    u8 difference = 0;
+    for (size_t i = 0; i < SESSION_KEY_SIZE; i++)
+    {
+        difference |= storedKey[i] ^ sessionKey[i];
+    }
+
+    return difference == 0;
+}
+
+u32 SessionKeyStore::Hash(u32 accountId)
+{
+    // Murmur3 finalizer, hash % SHARD_COUNT picks the shard and the remaining bits pick the slot
+    accountId ^= accountId >> 16;
+    accountId *= 0x85ebca6b;
+    accountId ^= accountId >> 13;
+    accountId *= 0xc2b2ae35;
+    accountId ^= accountId >> 16;
+    return accountId;
+}
+
+void SessionKeyStore::Read(const Entry& entry, EntrySnapshot& snapshot)
+{
+    while (true)
+    {
+        u32 sequence = entry.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+            continue;
+
+        snapshot.accountId = entry.accountId.load(std::memory_order_relaxed);
+        snapshot.expiresAtNS = entry.expiresAtNS.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < SESSION_KEY_SIZE / sizeof(u64); i++)
+        {
+            snapshot.sessionKey[i] = entry.sessionKey[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) == sequence)
+            return;
+    }
+}
+
+void SessionKeyStore::Write(Entry& entry, u32 accountId, u64 expiresAtNS, const u64* sessionKey)
+{
+    u32 sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    entry.accountId.store(accountId, std::memory_order_relaxed);
+    entry.expiresAtNS.store(expiresAtNS, std::memory_order_relaxed);
+    for (size_t i = 0; i < SESSION_KEY_SIZE / sizeof(u64); i++)
+    {
+        entry.sessionKey[i].store(sessionKey[i], std::memory_order_relaxed);
+    }
+
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+u32 SessionKeyStore::FindSlot(const Shard& shard, u32 hash, u32 accountId, EntrySnapshot& snapshot) const
+{
+    if (accountId == 0)
+        return MAX_PROBE_LENGTH;
+
+    for (u32 i = 0; i < MAX_PROBE_LENGTH; i++)
+    {
+        const Entry& entry = shard.entries[(hash / SHARD_COUNT + i) & _shardMask];
+
+        // The account id of a used slot can change under us, only a consistent snapshot tells whether it is ours
+        u32 entryAccountId = entry.accountId.load(std::memory_order_relaxed);
+        if (entryAccountId == 0)
+            break;
+
+        if (entryAccountId != accountId)
+            continue;
+
+        Read(entry, snapshot);
+        if (snapshot.accountId == accountId)
+            return i;
+    }
+
+    return MAX_PROBE_LENGTH;
+}
@@ -0,0 +1,91 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+constexpr size_t SESSION_KEY_SIZE = 32;
+typedef std::array<u8, SESSION_KEY_SIZE> SessionKey;
+
+// Session keys of authenticated accounts, keyed by account id, so world servers can validate a client over the internal connection.
+// The store is split into SHARD_COUNT shards, each a fixed size open addressing table of cache line sized entries.
+// Writers take their shard's lock, readers never lock: every entry is guarded by a sequence counter and a reader simply
+// retries if a writer touched the entry while it was copying it. Entries expire on their own, an expired entry reads as missing
+// and its slot is reused by the next insert that needs one.
+class SessionKeyStore
+{
+public:
+    SessionKeyStore(u32 capacity);
+
+    // Thread safe, replaces the account's previous key. When the probe window is full the entry closest to expiring is evicted
+    void Insert(u32 accountId, const SessionKey& sessionKey, u64 expiresAtNS, u64 nowNS);
+    // Thread safe, only removes the account's key if it still is sessionKey, so a newer login's key is never revoked by an older connection
+    bool RemoveIfMatches(u32 accountId, const SessionKey& sessionKey);
+
+    // Thread safe and lock free
+    bool Find(u32 accountId, u64 nowNS, SessionKey& sessionKey) const;
+    bool Validate(u32 accountId, const SessionKey& sessionKey, u64 nowNS) const;
+
+    u32 GetCapacity() const { return SHARD_COUNT * _shardSize; }
+
+    static constexpr u32 SHARD_COUNT = 16;
+    static constexpr u32 MAX_PROBE_LENGTH = 16;
+
+private:
+    struct alignas(64) Entry
+    {
+        std::atomic<u32> sequence = 0; // Odd while a writer is changing the entry
+        std::atomic<u32> accountId = 0; // 0 marks a slot that was never used, slots are never emptied again
+        std::atomic<u64> expiresAtNS = 0;
+        std::atomic<u64> sessionKey[SESSION_KEY_SIZE / sizeof(u64)] = {};
+    };
+
+    struct EntrySnapshot
+    {
+        u32 accountId;
+        u64 expiresAtNS;
+        u64 sessionKey[SESSION_KEY_SIZE / sizeof(u64)];
+    };
+
+    struct alignas(64) Shard
+    {
+        std::mutex writeMutex;
+        std::unique_ptr<Entry[]> entries;
+    };
+
+    static u32 Hash(u32 accountId);
+    static void Read(const Entry& entry, EntrySnapshot& snapshot);
+    static void Write(Entry& entry, u32 accountId, u64 expiresAtNS, const u64* sessionKey);
+
+    // Slot index of the account within its shard, or MAX_PROBE_LENGTH if it isn't stored
+    u32 FindSlot(const Shard& shard, u32 hash, u32 accountId, EntrySnapshot& snapshot) const;
+
+private:
+    Shard _shards[SHARD_COUNT];
+    u32 _shardSize;
+    u32 _shardMask;
+};
@@ -0,0 +1,10 @@
+#pragma once
+#include <NovusTypes.h>
+#include "../../Database/AccountBackend.h"
+
+// Assigned by the EngineLoop once the account lookup started by a connection's handshake completes
+struct AccountComponent
+{
+    bool found = false;
+    AccountRecord record;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <NovusTypes.h>
+#include <array>
+
+enum class AuthenticationStage : u8
+{
+    NONE,
+    ACCOUNT_LOOKUP, // Waiting for AccountComponent
+    AWAITING_PROOF, // Challenged, waiting for CMSG_HANDSHAKE_PROOF
+    VERIFYING_PROOF, // Waiting for the CryptoWorkerPool
+    AUTHENTICATED,
+    FAILED
+};
+
+// First byte of every SMSG_HANDSHAKE
+enum class HandshakeResult : u8
+{
+    CHALLENGE, // u8 salt[32], u8 serverNonce[32], answered with CMSG_HANDSHAKE_PROOF
+    AUTHENTICATED, // u32 account id, u8 sessionKey[32]
+    UNKNOWN_ACCOUNT,
+    INCORRECT_PROOF,
+    ALREADY_AUTHENTICATED,
+    BUSY // The server is shedding load, sent right before the connection is closed
+};
+
+// Progress of a client's handshake, the EngineLoop moves it along as the asynchronous steps complete
+struct AuthenticationState
+{
+    AuthenticationStage stage = AuthenticationStage::NONE;
+    std::array<u8, 32> serverNonce = {}; // New for every attempt, set by the EngineLoop together with isAccountLoaded
+    std::array<u8, 32> clientProof = {};
+    std::array<u8, 32> sessionKey = {}; // Set once AUTHENTICATED, also stored in the SessionKeyStore for the world servers
+    bool isAccountLoaded = false; // The AccountComponent belongs to this attempt
+    bool isProofReceived = false; // clientProof was read from the CMSG_HANDSHAKE_PROOF answering this attempt's challenge
+    bool isResultPending = false; // The handshake that reached AUTHENTICATED or FAILED hasn't been answered yet
+};
@@ -2,12 +2,25 @@
 #include <NovusTypes.h>
 #include <Networking/Connection.h>
 #include <Networking/Packet.h>
-#include <Utils/ConcurrentQueue.h>
+#include "../../Utils/SPSCRingBuffer.h"
+#include "PacketRetryState.h"
+#include "../../Utils/TimerWheel.h"
+#include "AuthenticationState.h"
 
 struct ConnectionComponent
 {
-    ConnectionComponent() : packetQueue(256) { }
+    static constexpr u32 PACKET_QUEUE_SIZE = 32;
 
     std::shared_ptr<Connection> connection;
-    moodycamel::ConcurrentQueue<Packet*> packetQueue;
+    u64 identity = 0; // Handle in the shard's ConnectionHandleTable
+    // Filled by EngineLoop::Update, drained by the packet handler system
+    SPSCRingBuffer<Packet*, PACKET_QUEUE_SIZE> packetQueue;
+    PacketRetryState retryState;
+    AuthenticationState authentication;
+    TimerHandle expiryTimer = 0; // Handshake deadline, then session expiry
+    TimerHandle retryTimer = 0;
+    u64 addressKey = 0; // RateLimiter bucket of the remote address
+    u32 queuedRealmId = 0; // Realm the client waits for a free instance of
+    u32 realmJoinSerial = 0; // Bumped by every realm join, queue entries of earlier joins don't match it anymore
+    bool isDirty = false; // Listed in DirtyConnectionsSingleton
 };
\ No newline at end of file
@@ -2,12 +2,19 @@
 #include <NovusTypes.h>
 #include <Networking/Connection.h>
 #include <Networking/Packet.h>
-#include <Utils/ConcurrentQueue.h>
+#include "../../Utils/SPSCRingBuffer.h"
+#include "PacketRetryState.h"
+#include "../../Utils/TimerWheel.h"
 
 struct InternalConnectionComponent
 {
-    InternalConnectionComponent() : packetQueue(256) { }
+    static constexpr u32 PACKET_QUEUE_SIZE = 32;
 
     std::shared_ptr<Connection> connection;
-    moodycamel::ConcurrentQueue<Packet*> packetQueue;
+    u64 identity = 0; // Handle in the shard's ConnectionHandleTable
+    // Filled by EngineLoop::Update, drained by the packet handler system
+    SPSCRingBuffer<Packet*, PACKET_QUEUE_SIZE> packetQueue;
+    PacketRetryState retryState;
+    TimerHandle retryTimer = 0;
+    bool isDirty = false; // Listed in DirtyConnectionsSingleton
 };
\ No newline at end of file
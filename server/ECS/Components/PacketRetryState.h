@@ -0,0 +1,25 @@
+#pragma once
+#include <NovusTypes.h>
+#include <algorithm>
+
+// Tracks the packet at the front of a connection's packetQueue after its handler returned false.
+// The packet stays queued and is retried with an exponential backoff until it succeeds or MAX_ATTEMPTS is reached.
+struct PacketRetryState
+{
+    static constexpr u16 MAX_ATTEMPTS = 10;
+    static constexpr u64 BASE_BACKOFF_NS = 10ull * 1000000;
+    static constexpr u64 MAX_BACKOFF_NS = 1000ull * 1000000;
+
+    // Retry on the next tick with a fresh set of attempts, for whoever finishes the work the handler was waiting on
+    void Wake()
+    {
+        attempts = 0;
+        retryAtNS = 0;
+    }
+
+    bool IsWaiting(u64 nowNS) const { return attempts > 0 && nowNS < retryAtNS; }
+    u64 GetBackoffNS() const { return std::min(BASE_BACKOFF_NS << std::min<u16>(attempts, 16), MAX_BACKOFF_NS); }
+
+    u16 attempts = 0;
+    u64 retryAtNS = 0; // TimeSingleton::tickTimeNS
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <NovusTypes.h>
+#include <entt.hpp>
+#include <vector>
+
+// Connections with packets waiting to be handled, maintained by EngineLoop::Update so the packet systems only visit connections with traffic.
+// A connection stays in here for as long as its packetQueue is not empty, the isDirty flag on its component keeps the lists free of duplicates.
+struct DirtyConnectionsSingleton
+{
+    std::vector<entt::entity> clientConnections;
+    std::vector<entt::entity> internalConnections;
+};
@@ -0,0 +1,8 @@
+#pragma once
+#include <NovusTypes.h>
+
+// Shard N handles the Nth slice of DirtyConnectionsSingleton::clientConnections and of internalConnections
+struct PacketHandlerShardSingleton
+{
+    u32 shardCount = 1;
+};
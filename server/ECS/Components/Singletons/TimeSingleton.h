@@ -1,9 +1,18 @@
 #pragma once
 #include <NovusTypes.h>
+#include <chrono>
 
 struct TimeSingleton
 {
     f32 deltaTime;
-    f32 lifeTimeInS;
-    f32 lifeTimeInMS;
+    u64 tickCount = 0;
+    u64 tickTimeNS = 0; // Now() at the start of the tick, use this for timeouts and scheduling
+
+    // Nanoseconds since the server started on a monotonic clock, for the few places that need better than tick precision
+    static u64 Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    inline static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
 };
\ No newline at end of file
@@ -1,27 +1,31 @@
 #include "InternalPacketHandlerSystem.h"
 #include "../Components/InternalConnectionComponent.h"
+#include "../Components/Singletons/PacketHandlerShardSingleton.h"
+#include "../Components/Singletons/DirtyConnectionsSingleton.h"
+#include "../Components/Singletons/TimeSingleton.h"
 #include "../../Networking/MessageHandler.h"
 #include "../../Utils/ServiceLocator.h"
+#include "PacketQueueProcessor.h"
 #include <tracy/Tracy.hpp>
 
-void InternalPacketHandlerSystem::Update(entt::registry& registry)
+void InternalPacketHandlerSystem::UpdateShard(entt::registry& registry, u32 shardIndex)
 {
+    PacketHandlerShardSingleton& shardSingleton = registry.ctx<PacketHandlerShardSingleton>();
+    DirtyConnectionsSingleton& dirtyConnectionsSingleton = registry.ctx<DirtyConnectionsSingleton>();
+    TimeSingleton& timeSingleton = registry.ctx<TimeSingleton>();
     MessageHandler* messageHandler = ServiceLocator::GetInternalMessageHandler();
-    auto view = registry.view<InternalConnectionComponent>();
-    view.each([&registry, &messageHandler](const auto, InternalConnectionComponent& internalConnectionComponent)
+
+    const std::vector<entt::entity>& connections = dirtyConnectionsSingleton.internalConnections;
+    size_t connectionCount = connections.size();
+    size_t begin = (connectionCount * shardIndex) / shardSingleton.shardCount;
+    size_t end = (connectionCount * (shardIndex + 1)) / shardSingleton.shardCount;
+
+    for (size_t i = begin; i < end; i++)
     {
-            ZoneScopedNC("InternalPacketHandlerSystem::Update", tracy::Color::Blue)
+        ZoneScopedNC("InternalPacketHandlerSystem::Update", tracy::Color::Blue)
 
-                Packet* packet;
-            while (internalConnectionComponent.packetQueue.try_dequeue(packet))
-            {
-                if (!messageHandler->CallHandler(packet))
-                {
-                    internalConnectionComponent.packetQueue.enqueue(packet);
-                    continue;
-                }
+        InternalConnectionComponent& internalConnectionComponent = registry.get<InternalConnectionComponent>(connections[i]);
 
-                delete packet;
-            }
-    });
+        PacketQueueProcessor::Process(messageHandler, internalConnectionComponent, timeSingleton.tickTimeNS);
+    }
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
+#include <NovusTypes.h>
 #include <entt.hpp>
 
+// Internal packets are handled in parallel the same way as client packets, see PacketHandlerSystem for the rules handlers have to follow.
+// Shard N handles the Nth slice of DirtyConnectionsSingleton::internalConnections
 class InternalPacketHandlerSystem
 {
 public:
-    static void Update(entt::registry& registry); 
+    static void UpdateShard(entt::registry& registry, u32 shardIndex);
 };
\ No newline at end of file
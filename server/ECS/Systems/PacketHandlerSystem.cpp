@@ -1,27 +1,31 @@
 #include "PacketHandlerSystem.h"
 #include "../Components/ConnectionComponent.h"
+#include "../Components/Singletons/PacketHandlerShardSingleton.h"
+#include "../Components/Singletons/DirtyConnectionsSingleton.h"
+#include "../Components/Singletons/TimeSingleton.h"
 #include "../../Networking/MessageHandler.h"
 #include "../../Utils/ServiceLocator.h"
+#include "PacketQueueProcessor.h"
 #include <tracy/Tracy.hpp>
 
-void PacketHandlerSystem::Update(entt::registry& registry)
+void PacketHandlerSystem::UpdateShard(entt::registry& registry, u32 shardIndex)
 {
+    PacketHandlerShardSingleton& shardSingleton = registry.ctx<PacketHandlerShardSingleton>();
+    DirtyConnectionsSingleton& dirtyConnectionsSingleton = registry.ctx<DirtyConnectionsSingleton>();
+    TimeSingleton& timeSingleton = registry.ctx<TimeSingleton>();
     MessageHandler* messageHandler = ServiceLocator::GetClientMessageHandler();
-    auto view = registry.view<ConnectionComponent>();
-    view.each([&registry, &messageHandler](const auto, ConnectionComponent& connectionComponent)
+
+    const std::vector<entt::entity>& connections = dirtyConnectionsSingleton.clientConnections;
+    size_t connectionCount = connections.size();
+    size_t begin = (connectionCount * shardIndex) / shardSingleton.shardCount;
+    size_t end = (connectionCount * (shardIndex + 1)) / shardSingleton.shardCount;
+
+    for (size_t i = begin; i < end; i++)
     {
-            ZoneScopedNC("PacketHandlerSystem::Update", tracy::Color::Blue)
+        ZoneScopedNC("PacketHandlerSystem::Update", tracy::Color::Blue)
 
-                Packet* packet;
-            while (connectionComponent.packetQueue.try_dequeue(packet))
-            {
-                if (!messageHandler->CallHandler(packet))
-                {
-                    connectionComponent.packetQueue.enqueue(packet);
-                    continue;
-                }
+        ConnectionComponent& connectionComponent = registry.get<ConnectionComponent>(connections[i]);
 
-                delete packet;
-            }
-    });
-}
\ No newline at end of file
+        PacketQueueProcessor::Process(messageHandler, connectionComponent, timeSingleton.tickTimeNS);
+    }
+}
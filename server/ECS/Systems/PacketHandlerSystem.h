@@ -1,8 +1,18 @@
 #pragma once
+#include <NovusTypes.h>
 #include <entt.hpp>
 
+// Client packets are handled in parallel, the connections with pending packets are split into PacketHandlerShardSingleton::shardCount shards
+// and every shard runs as its own taskflow task. All packets of a connection are handled by the same shard, in the order they arrived.
+//
+// Handlers registered on the client MessageHandler therefore run concurrently with each other and have to follow these rules:
+// - They may read and write the components of the entity the packet belongs to, resolved from packet->connection->GetIdentity()
+//   through the ConnectionHandleTable singleton.
+// - They may only read components of other entities, and registry singletons.
+// - They may not create or destroy entities or assign/remove components, pass a message to the EngineLoop for that instead.
+// - Any other state they share must be synchronized by whoever owns it.
 class PacketHandlerSystem
 {
 public:
-    static void Update(entt::registry& registry); 
-};
\ No newline at end of file
+    static void UpdateShard(entt::registry& registry, u32 shardIndex);
+};
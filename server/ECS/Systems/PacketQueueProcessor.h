@@ -0,0 +1,62 @@
+#pragma once
+#include <NovusTypes.h>
+#include <Networking/Packet.h>
+#include "../Components/PacketRetryState.h"
+#include "../Components/ConnectionComponent.h"
+#include "../Components/InternalConnectionComponent.h"
+#include "../Components/Singletons/TimeSingleton.h"
+#include "../../Networking/MessageHandler.h"
+#include "../../Utils/PacketPool.h"
+#include "../../Utils/Metrics.h"
+#include "../../Utils/AsyncLogger.h"
+
+// Shared by PacketHandlerSystem and InternalPacketHandlerSystem
+class PacketQueueProcessor
+{
+public:
+    // Handles the queued packets of one connection in order. When a handler returns false its packet stays at the front
+    // of the queue and the connection is skipped until the backoff in retryState runs out.
+    template <typename ConnectionComponentType>
+    static void Process(MessageHandler* messageHandler, ConnectionComponentType& connectionComponent, u64 nowNS)
+    {
+        PacketRetryState& retryState = connectionComponent.retryState;
+        if (retryState.IsWaiting(nowNS))
+            return;
+
+        Packet* packet;
+        while (connectionComponent.packetQueue.Peek(packet))
+        {
+            u64 handlerStartNS = TimeSingleton::Now();
+            bool handled = messageHandler->CallHandler(packet);
+            Metrics::Record(MetricHistogram::HANDLER_TIME, TimeSingleton::Now() - handlerStartNS);
+
+            if (!handled)
+            {
+                retryState.attempts++;
+                if (retryState.attempts < PacketRetryState::MAX_ATTEMPTS)
+                {
+                    retryState.retryAtNS = nowNS + retryState.GetBackoffNS();
+                    return;
+                }
+
+                Metrics::Increment(MetricCounter::PACKETS_DROPPED);
+                NC_ASYNC_LOG_WARNING("Dropped packet (opcode %u) after %u attempts", static_cast<u32>(packet->header.opcode), static_cast<u32>(retryState.attempts));
+                OnPacketDropped(connectionComponent);
+            }
+
+            retryState.attempts = 0;
+            connectionComponent.packetQueue.Pop();
+            PacketPool::Release(packet);
+        }
+    }
+
+private:
+    // The dropped packet was the handshake waiting on its account or proof, nothing else moves the client past that stage
+    static void OnPacketDropped(ConnectionComponent& connectionComponent)
+    {
+        AuthenticationStage& stage = connectionComponent.authentication.stage;
+        if (stage == AuthenticationStage::ACCOUNT_LOOKUP || stage == AuthenticationStage::VERIFYING_PROOF)
+            stage = AuthenticationStage::FAILED;
+    }
+    static void OnPacketDropped(InternalConnectionComponent&) { }
+};
@@ -1,31 +1,71 @@
 #include "EngineLoop.h"
 #include <thread>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 #include <Utils/Timer.h>
 #include "Utils/ServiceLocator.h"
-#include <Networking/InputQueue.h>
+#include "Utils/PacketPool.h"
+#include "Utils/Metrics.h"
+#include "Utils/AsyncLogger.h"
+#include "Utils/TimerWheel.h"
+#include "Utils/PacketCapture.h"
+#include "Database/AccountQueryService.h"
+#include "Cryptography/CryptoWorkerPool.h"
+#include "Database/SessionKeyStore.h"
+#include "Networking/RealmRegistry.h"
 #include <Networking/Connection.h>
-#include "Networking/MessageHandler.h"
+#include "Networking/ConnectionHandleTable.h"
+#include "Networking/ConnectionIdentity.h"
+#include "Networking/ConnectionCloser.h"
+#include "Networking/PacketSender.h"
+#include "Networking/Opcodes.h"
 #include <tracy/Tracy.hpp>
 
 // Component Singletons
 #include "ECS/Components/Singletons/TimeSingleton.h"
+#include "ECS/Components/Singletons/PacketHandlerShardSingleton.h"
+#include "ECS/Components/Singletons/DirtyConnectionsSingleton.h"
 
 // Components
 #include "ECS/Components/ConnectionComponent.h"
 #include "ECS/Components/InternalConnectionComponent.h"
+#include "ECS/Components/AccountComponent.h"
 
 // Systems
 #include "ECS/Systems/PacketHandlerSystem.h"
 #include "ECS/Systems/InternalPacketHandlerSystem.h"
 
-// Handlers
-#include "Networking/Handlers/Server/GeneralHandlers.h"
+// ExpiredTimer::type of the timers EngineLoop schedules, ExpiredTimer::data is the ConnectionIdentity of the connection
+enum ConnectionTimerType : u32
+{
+    HANDSHAKE_DEADLINE,
+    SESSION_EXPIRY,
+    CLIENT_PACKET_RETRY,
+    INTERNAL_PACKET_RETRY
+};
+
+constexpr u64 TIMER_RESOLUTION_NS = 10 * 1000 * 1000;
 
-EngineLoop::EngineLoop(f32 targetTickRate)
-    : _isRunning(false), _inputQueue(256), _outputQueue(256)
+EngineLoop::EngineLoop(f32 targetTickRate, EngineLoopMode mode, u32 shardIndex, u32 shardCount)
+    : _shardIndex(shardIndex), _isRunning(false), _isShedding(false), _wakeRequested(false), _wakePollInterval(1000), _handshakeTimeout(30), _sessionTimeout(15 * 60), _timerWheel(TIMER_RESOLUTION_NS), _droppedPacketCount(0), _droppedPacketsLoggedAtNS(0), _closedConnectionCount(0), _packetCaptureRecorder(shardIndex), _isCapturingPackets(false), _inputQueue(256), _controlQueue(64), _outputQueue(256),
+      _updateFramework(std::max(std::thread::hardware_concurrency() / std::max(shardCount, 1u), 1u))
 {
+    // Every engine shard gets its share of the cores for its taskflow workers,
+    // a few packet handler shards per worker lets them even out connections that are busier than others
+    _packetHandlerShardCount = std::max(std::thread::hardware_concurrency() / std::max(shardCount, 1u), 1u) * 4;
+
+    _inputLaneBudgets[static_cast<u32>(InputLane::CONTROL)] = 1024;
+    _inputLaneBudgets[static_cast<u32>(InputLane::INTERNAL)] = 4096;
+    _inputLaneBudgets[static_cast<u32>(InputLane::CLIENT)] = 8192;
+
+    // Shed after falling a few ticks behind, accept again once a tick's worth is left
+    _clientLaneHighWatermark = 32768;
+    _clientLaneLowWatermark = 8192;
+    _inputQueueCapacity = 65536;
+
     _targetTickRate = targetTickRate;
+    _mode = mode;
 }
 
 EngineLoop::~EngineLoop()
@@ -37,9 +77,6 @@ void EngineLoop::Start()
     if (_isRunning)
         return;
 
-    // Setup Network Lib
-    InputQueue::SetInputQueue(&_inputQueue);
-
     std::thread thread = std::thread(&EngineLoop::Run, this);
     thread.detach();
 }
@@ -49,17 +86,37 @@ void EngineLoop::Stop()
     if (!_isRunning)
         return;
 
-    Message message;
-    message.code = MSG_IN_EXIT;
-    PassMessage(message);
+    PassMessage(EngineInputMessage(EngineInputType::EXIT));
 }
 
-void EngineLoop::PassMessage(Message& message)
+void EngineLoop::PassMessage(const EngineInputMessage& message)
 {
-    _inputQueue.enqueue(message);
+    // Network messages take the same path as the ones from the network library so they keep their order
+    if (message.type == EngineInputType::CLIENT_PACKET || message.type == EngineInputType::INTERNAL_PACKET || message.type == EngineInputType::DISCONNECT)
+    {
+        // The backlog is bounded here, internal packets and disconnects always get in so nothing of ours is lost
+        if (message.type == EngineInputType::CLIENT_PACKET && _inputQueue.size_approx() >= _inputQueueCapacity)
+        {
+            PacketPool::Release(message.packet);
+            Metrics::Increment(MetricCounter::PACKETS_SHED);
+            return;
+        }
+
+        _inputQueue.enqueue(message);
+    }
+    else
+    {
+        _controlQueue.enqueue(message);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _wakeRequested = true;
+    }
+    _wakeCondition.notify_one();
 }
 
-bool EngineLoop::TryGetMessage(Message& message)
+bool EngineLoop::TryGetMessage(EngineOutputMessage& message)
 {
     return _outputQueue.try_dequeue(message);
 }
@@ -83,29 +140,22 @@ void EngineLoop::Run()
         f32 deltaTime = timer.GetDeltaTime();
         timer.Tick();
 
-        timeSingleton.lifeTimeInS = timer.GetLifeTime();
-        timeSingleton.lifeTimeInMS = timeSingleton.lifeTimeInS * 1000;
+        timeSingleton.tickTimeNS = TimeSingleton::Now();
+        timeSingleton.tickCount++;
         timeSingleton.deltaTime = deltaTime;
 
         if (!Update())
             break;
 
-        {
-            ZoneScopedNC("WaitForTickRate", tracy::Color::AntiqueWhite1)
+        Metrics::Record(MetricHistogram::TICK_DURATION, TimeSingleton::Now() - timeSingleton.tickTimeNS);
 
-            // Wait for tick rate, this might be an overkill implementation but it has the even tickrate I've seen - MPursche
-            {
-                ZoneScopedNC("Sleep", tracy::Color::AntiqueWhite1) for (deltaTime = timer.GetDeltaTime(); deltaTime < targetDelta - 0.0025f; deltaTime = timer.GetDeltaTime())
-                {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                }
-            }
-            {
-                ZoneScopedNC("Yield", tracy::Color::AntiqueWhite1) for (deltaTime = timer.GetDeltaTime(); deltaTime < targetDelta; deltaTime = timer.GetDeltaTime())
-                {
-                    std::this_thread::yield();
-                }
-            }
+        if (_mode == EngineLoopMode::EVENT_DRIVEN)
+        {
+            WaitForWork(timer, targetDelta);
+        }
+        else
+        {
+            WaitForTickRate(timer, targetDelta);
         }
 
         FrameMark
@@ -113,138 +163,712 @@ void EngineLoop::Run()
 
     // Clean up stuff here
 
-    Message exitMessage;
-    exitMessage.code = MSG_OUT_EXIT_CONFIRM;
-    _outputQueue.enqueue(exitMessage);
+    _outputQueue.enqueue(EngineOutputMessage(EngineOutputType::EXIT_CONFIRM));
+}
+
+void EngineLoop::WaitForTickRate(Timer& timer, f32 targetDelta)
+{
+    ZoneScopedNC("WaitForTickRate", tracy::Color::AntiqueWhite1)
+
+    // Wait for tick rate, this might be an overkill implementation but it has the even tickrate I've seen - MPursche
+    {
+        ZoneScopedNC("Sleep", tracy::Color::AntiqueWhite1) for (f32 deltaTime = timer.GetDeltaTime(); deltaTime < targetDelta - 0.0025f; deltaTime = timer.GetDeltaTime())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    {
+        ZoneScopedNC("Yield", tracy::Color::AntiqueWhite1) for (f32 deltaTime = timer.GetDeltaTime(); deltaTime < targetDelta; deltaTime = timer.GetDeltaTime())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void EngineLoop::WaitForWork(Timer& timer, f32 maxDelta)
+{
+    ZoneScopedNC("WaitForWork", tracy::Color::AntiqueWhite1)
+
+    // PassMessage wakes us up directly, _wakePollInterval only bounds how long a missed wakeup can delay us
+    std::unique_lock<std::mutex> lock(_wakeMutex);
+    for (f32 deltaTime = timer.GetDeltaTime(); deltaTime < maxDelta; deltaTime = timer.GetDeltaTime())
+    {
+        if (_wakeRequested || _inputQueue.size_approx() > 0 || _controlQueue.size_approx() > 0 || !_internalLane.empty() || !_clientLane.empty())
+            break;
+
+        std::chrono::microseconds timeLeft = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<f32>(maxDelta - deltaTime));
+        _wakeCondition.wait_for(lock, std::min(timeLeft, _wakePollInterval));
+    }
+
+    _wakeRequested = false;
 }
 
 bool EngineLoop::Update()
 {
     ZoneScopedNC("Update", tracy::Color::Blue2)
+
     {
         ZoneScopedNC("HandleMessages", tracy::Color::Green3)
-            Message message;
 
-        while (_inputQueue.try_dequeue(message))
+        Metrics::SetGauge(MetricGauge::INPUT_QUEUE_DEPTH, _inputQueue.size_approx());
+        Metrics::SetGauge(MetricGauge::OUTPUT_QUEUE_DEPTH, _outputQueue.size_approx());
+
+        SortInputQueue();
+        Metrics::SetGauge(MetricGauge::INTERNAL_LANE_DEPTH, _internalLane.size());
+        Metrics::SetGauge(MetricGauge::CLIENT_LANE_DEPTH, _clientLane.size());
+
+        // Control and internal traffic go first so a client flood can't hold up our world servers or an exit,
+        // whatever is left over after a lane's budget waits for the next tick
+        EngineInputMessage message;
+        for (u32 budget = _inputLaneBudgets[static_cast<u32>(InputLane::CONTROL)]; budget > 0 && _controlQueue.try_dequeue(message); budget--)
         {
-            if (message.code == -1)
-                assert(false);
+            if (!HandleMessage(message))
+                return false;
+        }
 
-            if (message.code == MSG_IN_EXIT)
+        if (!DrainInputLane(_internalLane, _inputLaneBudgets[static_cast<u32>(InputLane::INTERNAL)]))
+            return false;
+
+        if (!DrainInputLane(_clientLane, _inputLaneBudgets[static_cast<u32>(InputLane::CLIENT)]))
+            return false;
+    }
+
+    LogDroppedPackets();
+    HandleAccountQueryResults();
+    UpdateTimers();
+    CompactDirtyConnections();
+    UpdateSystems();
+
+    Metrics::SetGauge(MetricGauge::CLIENT_CONNECTIONS, _updateFramework.registry.size<ConnectionComponent>());
+    Metrics::SetGauge(MetricGauge::INTERNAL_CONNECTIONS, _updateFramework.registry.size<InternalConnectionComponent>());
+
+    // Everything the handlers asked for this tick goes out as one set of batches
+    ServiceLocator::GetAccountQueryService()->Flush();
+    ServiceLocator::GetCryptoWorkerPool()->Flush();
+
+    // Realm changes reported this tick are serialized once for every client that asks for the list
+    AssignQueuedClients();
+    ServiceLocator::GetRealmRegistry()->Publish();
+    return true;
+}
+
+void EngineLoop::SortInputQueue()
+{
+    ZoneScopedNC("SortInputQueue", tracy::Color::Green3)
+
+    constexpr size_t SORT_BATCH_SIZE = 64;
+    EngineInputMessage messages[SORT_BATCH_SIZE];
+
+    _isCapturingPackets = _packetCaptureRecorder.Begin(ServiceLocator::GetPacketCaptureWriter());
+
+    // Only what the lanes hand out this tick is taken, the backlog stays in _inputQueue where PassMessage bounds it
+    size_t laneCapacity = _inputLaneBudgets[static_cast<u32>(InputLane::INTERNAL)] + _inputLaneBudgets[static_cast<u32>(InputLane::CLIENT)];
+    size_t laneSize = _internalLane.size() + _clientLane.size();
+    while (laneSize < laneCapacity)
+    {
+        size_t count = _inputQueue.try_dequeue_bulk(messages, std::min(SORT_BATCH_SIZE, laneCapacity - laneSize));
+        if (count == 0)
+            break;
+
+        laneSize += count;
+
+        // Captured before shedding so a replay puts the engine under the same load
+        if (_isCapturingPackets)
+        {
+            // Messages the router passed on before the capture started aren't stamped
+            u64 nowNS = TimeSingleton::Now();
+            for (size_t i = 0; i < count; i++)
             {
-                return false;
+                const EngineInputMessage& message = messages[i];
+                u64 receivedNS = message.receivedNS ? message.receivedNS : nowNS;
+
+                if (message.type == EngineInputType::CLIENT_PACKET)
+                    _packetCaptureRecorder.RecordPacket(PacketCaptureType::CLIENT_PACKET, *message.packet, receivedNS);
+                else if (message.type == EngineInputType::INTERNAL_PACKET)
+                    _packetCaptureRecorder.RecordPacket(PacketCaptureType::INTERNAL_PACKET, *message.packet, receivedNS);
+                else if (message.type == EngineInputType::DISCONNECT)
+                    _packetCaptureRecorder.RecordDisconnect(message.identity, receivedNS);
             }
-            else if (message.code == MSG_IN_PING)
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            InputLane lane = GetInputLane(messages[i]);
+            if (lane == InputLane::CLIENT)
+            {
+                if (ShouldShed(messages[i]))
+                    continue;
+
+                _clientLane.push_back(messages[i]);
+            }
+            else if (lane == InputLane::INTERNAL)
             {
-                ZoneScopedNC("Ping", tracy::Color::Green3)
-                    Message pongMessage;
-                pongMessage.code = MSG_OUT_PRINT;
-                pongMessage.message = new std::string("PONG!");
-                _outputQueue.enqueue(pongMessage);
+                _internalLane.push_back(messages[i]);
             }
-            else if (message.code == MSG_IN_NET_PACKET)
+            else
             {
-                Packet* packet = reinterpret_cast<Packet*>(message.object);
-                ConnectionComponent* connectionComponent = nullptr;
-
-                if (u64 identity = packet->connection->GetIdentity())
-                {
-                    entt::entity entity = static_cast<entt::entity>(identity);
-                    connectionComponent = &_updateFramework.registry.get<ConnectionComponent>(entity);
-                }
-                else
-                {
-                    entt::entity entity = _updateFramework.registry.create();
-                    connectionComponent = &_updateFramework.registry.assign<ConnectionComponent>(entity);
-                    connectionComponent->connection = std::make_shared<Connection>(*packet->connection);
-
-                    u64 entityId = entt::to_integer(entity);
-                    packet->connection->SetIdentity(entityId);
-                }
-;
-                connectionComponent->packetQueue.enqueue(packet);
+                _controlQueue.enqueue(messages[i]);
             }
-            else if (message.code == MSG_IN_INTERNAL_NET_PACKET)
+        }
+    }
+
+    if (_isCapturingPackets)
+        _packetCaptureRecorder.Flush();
+}
+
+bool EngineLoop::ShouldShed(const EngineInputMessage& message)
+{
+    // The backlog is whatever hasn't been handled yet, most of it waits in _inputQueue
+    size_t backlog = _inputQueue.size_approx() + _clientLane.size();
+    if (!_isShedding && backlog >= _clientLaneHighWatermark)
+    {
+        _isShedding = true;
+        Metrics::SetGauge(MetricGauge::LOAD_SHEDDING, 1);
+        NC_ASYNC_LOG_WARNING("Shard %u: client backlog is over %u messages, shedding new connections and flooding ones", _shardIndex, _clientLaneHighWatermark);
+    }
+    else if (_isShedding && backlog <= _clientLaneLowWatermark)
+    {
+        _isShedding = false;
+        Metrics::SetGauge(MetricGauge::LOAD_SHEDDING, 0);
+        NC_ASYNC_LOG_MESSAGE("Shard %u: client backlog is back under %u messages, accepting new connections", _shardIndex, _clientLaneLowWatermark);
+    }
+
+    // New connections are turned away here, connections that already have an entity are closed by HandleMessage if they flood their queue
+    if (!_isShedding || message.type != EngineInputType::CLIENT_PACKET)
+        return false;
+
+    Packet* packet = message.packet;
+    if (packet->connection->GetIdentity())
+        return false;
+
+    // The close is posted after the answer, so the client gets to read why it was turned away
+    PacketWriter writer;
+    writer.Put<u8>(static_cast<u8>(HandshakeResult::BUSY));
+    PacketSender::Send(*packet->connection, Opcode::SMSG_HANDSHAKE, writer);
+
+    u64 closedIdentity = ConnectionIdentity::MakeClosed(_shardIndex, _closedConnectionCount++);
+    packet->connection->SetIdentity(closedIdentity);
+    if (_isCapturingPackets)
+        _packetCaptureRecorder.BindIdentity(*packet, closedIdentity);
+    ConnectionCloser::Close(*packet->connection);
+
+    PacketPool::Release(packet);
+    Metrics::Increment(MetricCounter::PACKETS_SHED);
+    return true;
+}
+
+InputLane EngineLoop::GetInputLane(const EngineInputMessage& message)
+{
+    if (message.type == EngineInputType::CLIENT_PACKET)
+        return InputLane::CLIENT;
+
+    if (message.type == EngineInputType::INTERNAL_PACKET)
+        return InputLane::INTERNAL;
+
+    if (message.type == EngineInputType::DISCONNECT)
+    {
+        // A disconnect has to stay behind the packets of its connection, so it goes into the same lane
+        if (_updateFramework.registry.ctx<ConnectionHandleTable>().GetKind(message.identity) == ConnectionKind::INTERNAL)
+            return InputLane::INTERNAL;
+
+        return InputLane::CLIENT;
+    }
+
+    return InputLane::CONTROL;
+}
+
+bool EngineLoop::DrainInputLane(std::deque<EngineInputMessage>& lane, u32 budget)
+{
+    for (; budget > 0 && !lane.empty(); budget--)
+    {
+        EngineInputMessage message = lane.front();
+        lane.pop_front();
+
+        if (!HandleMessage(message))
+            return false;
+    }
+
+    return true;
+}
+
+bool EngineLoop::HandleMessage(const EngineInputMessage& message)
+{
+    if (message.type == EngineInputType::NONE)
+        assert(false);
+
+    if (message.type == EngineInputType::EXIT)
+    {
+        return false;
+    }
+    else if (message.type == EngineInputType::PING)
+    {
+        ZoneScopedNC("Ping", tracy::Color::Green3)
+        PrintMessage("PONG! (shard %u)", _shardIndex);
+    }
+    else if (message.type == EngineInputType::CLIENT_PACKET)
+    {
+        Packet* packet = message.packet;
+        ConnectionHandleTable& connectionHandles = _updateFramework.registry.ctx<ConnectionHandleTable>();
+        ConnectionComponent* connectionComponent = nullptr;
+        entt::entity entity = entt::null;
+
+        Metrics::Increment(MetricCounter::PACKETS_RECEIVED);
+        Metrics::IncrementOpcode(packet->header.opcode);
+
+        // Rate limited before anything else is done with the packet, a banned address doesn't even get an entity
+        u64 identity = packet->connection->GetIdentity();
+        if (identity)
+        {
+            // Sent before a disconnect and handled after it, or we disconnected it ourselves (e.g. it timed out) and the network library
+            // hasn't caught up yet. The slot may already belong to a new connection, its generation tells them apart
+            entity = connectionHandles.Resolve(identity, ConnectionKind::CLIENT);
+            if (entity == entt::null)
             {
-                Packet* packet = reinterpret_cast<Packet*>(message.object);
-                InternalConnectionComponent* internalConnectionComponent = nullptr;
-
-                if (u64 identity = packet->connection->GetIdentity())
-                {
-                    entt::entity entity = static_cast<entt::entity>(identity);
-                    internalConnectionComponent = &_updateFramework.registry.get<InternalConnectionComponent>(entity);
-                }
-                else
-                {
-                    entt::entity entity = _updateFramework.registry.create();
-                    internalConnectionComponent = &_updateFramework.registry.assign<InternalConnectionComponent>(entity);
-                    internalConnectionComponent->connection = std::make_shared<Connection>(*packet->connection);
-
-                    u64 entityId = entt::to_integer(entity);
-                    packet->connection->SetIdentity(entityId);
-                }
-
-                internalConnectionComponent->packetQueue.enqueue(packet);
+                PacketPool::Release(packet);
+                Metrics::Increment(MetricCounter::PACKETS_DROPPED);
+                return true;
             }
-            else if (message.code == MSG_IN_NET_DISCONNECT)
+
+            connectionComponent = &_updateFramework.registry.get<ConnectionComponent>(entity);
+        }
+
+        u64 addressKey = connectionComponent ? connectionComponent->addressKey : RateLimiter::GetAddressKey(*packet->connection);
+        u64 nowNS = _updateFramework.registry.ctx<TimeSingleton>().tickTimeNS;
+        if (_rateLimiter.CheckAddress(addressKey, nowNS) != RateLimitResult::ALLOWED)
+        {
+            if (!identity && _isCapturingPackets)
+                _packetCaptureRecorder.ForgetConnection(*packet);
+
+            PacketPool::Release(packet);
+            Metrics::Increment(MetricCounter::PACKETS_RATE_LIMITED);
+            return true;
+        }
+
+        if (!identity)
+        {
+            entity = _updateFramework.registry.create();
+            connectionComponent = &_updateFramework.registry.assign<ConnectionComponent>(entity);
+            connectionComponent->connection = std::make_shared<Connection>(*packet->connection);
+            connectionComponent->addressKey = addressKey;
+            connectionComponent->identity = connectionHandles.Create(ConnectionKind::CLIENT, entity);
+            connectionComponent->expiryTimer = _timerWheel.Schedule(nowNS + _handshakeTimeout.count() * 1000000000ull, HANDSHAKE_DEADLINE, connectionComponent->identity);
+
+            packet->connection->SetIdentity(connectionComponent->identity);
+            if (_isCapturingPackets)
+                _packetCaptureRecorder.BindIdentity(*packet, connectionComponent->identity);
+            Metrics::Increment(MetricCounter::CONNECTIONS_OPENED);
+        }
+
+        if (!connectionComponent->packetQueue.Push(packet))
+        {
+            // The connection is sending faster than we handle its packets, drop instead of growing the queue
+            PacketPool::Release(packet);
+            Metrics::Increment(MetricCounter::PACKETS_DROPPED);
+            _droppedPacketCount++;
+
+            // While the shard is behind a connection that keeps its queue full is what's holding it up, close it
+            if (_isShedding)
             {
-                u64 identity = *reinterpret_cast<u64*>(message.object);
-                if (identity)
-                {
-                    entt::entity entity = static_cast<entt::entity>(identity);
-                    _updateFramework.registry.destroy(entity);
-                }
-
-                delete message.object;
+                ConnectionCloser::Close(*connectionComponent->connection);
+                DestroyConnection(entity);
+                Metrics::Increment(MetricCounter::CONNECTIONS_SHED);
             }
         }
+        else if (!connectionComponent->isDirty)
+        {
+            connectionComponent->isDirty = true;
+            _updateFramework.registry.ctx<DirtyConnectionsSingleton>().clientConnections.push_back(entity);
+        }
+    }
+    else if (message.type == EngineInputType::INTERNAL_PACKET)
+    {
+        Packet* packet = message.packet;
+        ConnectionHandleTable& connectionHandles = _updateFramework.registry.ctx<ConnectionHandleTable>();
+        InternalConnectionComponent* internalConnectionComponent = nullptr;
+        entt::entity entity = entt::null;
+
+        Metrics::Increment(MetricCounter::INTERNAL_PACKETS_RECEIVED);
+        Metrics::IncrementOpcode(packet->header.opcode);
+
+        if (u64 identity = packet->connection->GetIdentity())
+        {
+            entity = connectionHandles.Resolve(identity, ConnectionKind::INTERNAL);
+            if (entity == entt::null)
+            {
+                PacketPool::Release(packet);
+                Metrics::Increment(MetricCounter::PACKETS_DROPPED);
+                return true;
+            }
+
+            internalConnectionComponent = &_updateFramework.registry.get<InternalConnectionComponent>(entity);
+        }
+        else
+        {
+            entity = _updateFramework.registry.create();
+            internalConnectionComponent = &_updateFramework.registry.assign<InternalConnectionComponent>(entity);
+            internalConnectionComponent->connection = std::make_shared<Connection>(*packet->connection);
+            internalConnectionComponent->identity = connectionHandles.Create(ConnectionKind::INTERNAL, entity);
+
+            packet->connection->SetIdentity(internalConnectionComponent->identity);
+            if (_isCapturingPackets)
+                _packetCaptureRecorder.BindIdentity(*packet, internalConnectionComponent->identity);
+            Metrics::Increment(MetricCounter::CONNECTIONS_OPENED);
+        }
+
+        if (!internalConnectionComponent->packetQueue.Push(packet))
+        {
+            // The connection is sending faster than we handle its packets, drop instead of growing the queue
+            PacketPool::Release(packet);
+            Metrics::Increment(MetricCounter::PACKETS_DROPPED);
+            _droppedPacketCount++;
+        }
+        else if (!internalConnectionComponent->isDirty)
+        {
+            internalConnectionComponent->isDirty = true;
+            _updateFramework.registry.ctx<DirtyConnectionsSingleton>().internalConnections.push_back(entity);
+        }
+    }
+    else if (message.type == EngineInputType::CRYPTO_RESULT)
+    {
+        HandlePasswordProofResults(*message.cryptoResult);
+        delete message.cryptoResult;
+    }
+    else if (message.type == EngineInputType::DISCONNECT)
+    {
+        u64 identity = message.identity;
+        ConnectionHandleTable& connectionHandles = _updateFramework.registry.ctx<ConnectionHandleTable>();
+
+        // Connections we timed out are already gone
+        ConnectionKind kind = connectionHandles.GetKind(identity);
+        if (kind != ConnectionKind::NONE)
+            DestroyConnection(connectionHandles.Resolve(identity, kind));
     }
 
-    UpdateSystems();
     return true;
 }
 
-void EngineLoop::SetupUpdateFramework()
+void EngineLoop::LogDroppedPackets()
 {
-    tf::Framework& framework = _updateFramework.framework;
+    // A flooding connection drops a packet for every one it sends, one line a second is enough to notice
+    constexpr u64 DROPPED_PACKETS_LOG_INTERVAL_NS = 1000000000ull;
+
+    u64 nowNS = _updateFramework.registry.ctx<TimeSingleton>().tickTimeNS;
+    if (_droppedPacketCount == 0 || nowNS - _droppedPacketsLoggedAtNS < DROPPED_PACKETS_LOG_INTERVAL_NS)
+        return;
+
+    NC_ASYNC_LOG_WARNING("Shard %u: dropped %u packets because the packet queues of their connections were full", _shardIndex, _droppedPacketCount);
+    _droppedPacketCount = 0;
+    _droppedPacketsLoggedAtNS = nowNS;
+}
+
+void EngineLoop::HandleAccountQueryResults()
+{
+    ZoneScopedNC("HandleAccountQueryResults", tracy::Color::Green3)
+
     entt::registry& registry = _updateFramework.registry;
+    TimeSingleton& timeSingleton = registry.ctx<TimeSingleton>();
+    ConnectionHandleTable& connectionHandles = registry.ctx<ConnectionHandleTable>();
+    AccountQueryService* accountQueryService = ServiceLocator::GetAccountQueryService();
+
+    AccountQueryResult result;
+    while (accountQueryService->TryGetResult(_shardIndex, result))
+    {
+        // The connection might have disconnected while the query was running
+        entt::entity entity = connectionHandles.Resolve(result.identity, ConnectionKind::CLIENT);
+        if (entity == entt::null)
+            continue;
+
+        // Or its handshake gave up waiting for it
+        ConnectionComponent* connectionComponent = &registry.get<ConnectionComponent>(entity);
+        if (connectionComponent->authentication.stage != AuthenticationStage::ACCOUNT_LOOKUP)
+            continue;
+
+        // Too many failed attempts on this account, fail it before its proof costs us a verification
+        if (result.found && ServiceLocator::GetAccountRateLimiter()->IsAccountBanned(result.record.name, timeSingleton.tickTimeNS))
+        {
+            connectionComponent->authentication.stage = AuthenticationStage::FAILED;
+            connectionComponent->authentication.isResultPending = true;
+            WakeConnection(entity, *connectionComponent);
+            Metrics::Increment(MetricCounter::LOGINS_RATE_LIMITED);
+            continue;
+        }
 
-    ServiceLocator::SetMainRegistry(&registry);
-    SetupClientMessageHandler();
-    SetupServerMessageHandler();
+        AccountComponent& accountComponent = registry.assign_or_replace<AccountComponent>(entity);
+        accountComponent.found = result.found;
+        accountComponent.record = std::move(result.record);
+        connectionComponent->authentication.isAccountLoaded = true;
 
-    // @TODO: Temporary fix to allow taskflow to run multiple tasks at the same time when using Entt to construct views
-    registry.prepare<ConnectionComponent>();
-    registry.prepare<InternalConnectionComponent>();
+        // The handshake handler challenges the client with it, generated here since the handlers run on the taskflow workers
+        if (result.found)
+            GenerateRandomBytes(connectionComponent->authentication.serverNonce);
 
-    // PacketHandlerSystem
-    tf::Task packetHandlerSystemTask = framework.emplace([&registry]()
+        WakeConnection(entity, *connectionComponent);
+    }
+}
+
+template <typename ConnectionComponentType>
+void MarkConnectionDirty(ConnectionComponentType& connectionComponent, entt::entity entity, std::vector<entt::entity>& dirtyConnections)
+{
+    if (connectionComponent.isDirty)
+        return;
+
+    connectionComponent.isDirty = true;
+    dirtyConnections.push_back(entity);
+}
+
+template <typename ConnectionComponentType>
+void RemoveCleanConnections(entt::registry& registry, std::vector<entt::entity>& connections, TimerWheel& timerWheel, u32 retryTimerType, u64 nowNS)
+{
+    auto newEnd = std::remove_if(connections.begin(), connections.end(), [&](entt::entity entity)
     {
-        ZoneScopedNC("PacketHandlerSystem::Update", tracy::Color::Orange2)
-        PacketHandlerSystem::Update(registry);
+        // Destroyed by a disconnect
+        if (!registry.valid(entity))
+            return true;
+
+        ConnectionComponentType& connectionComponent = registry.get<ConnectionComponentType>(entity);
+        if (!connectionComponent.packetQueue.IsEmpty())
+        {
+            if (!connectionComponent.retryState.IsWaiting(nowNS))
+                return false;
+
+            // Waiting out a retry backoff, a timer puts it back once the backoff is over so the systems don't keep visiting it
+            if (!timerWheel.IsActive(connectionComponent.retryTimer))
+            {
+                connectionComponent.retryTimer = timerWheel.Schedule(connectionComponent.retryState.retryAtNS, retryTimerType, connectionComponent.identity);
+            }
+        }
+
+        connectionComponent.isDirty = false;
+        return true;
     });
+    connections.erase(newEnd, connections.end());
+}
 
-    // InternalPacketHandlerSystem
-    tf::Task internalPacketHandlerSystemTask = framework.emplace([&registry]()
+void EngineLoop::WakeConnection(entt::entity entity, ConnectionComponent& connectionComponent)
+{
+    connectionComponent.retryState.Wake();
+    _timerWheel.Cancel(connectionComponent.retryTimer);
+
+    if (!connectionComponent.packetQueue.IsEmpty())
+        MarkConnectionDirty(connectionComponent, entity, _updateFramework.registry.ctx<DirtyConnectionsSingleton>().clientConnections);
+}
+
+void EngineLoop::UpdateTimers()
+{
+    ZoneScopedNC("UpdateTimers", tracy::Color::Green3)
+
+    entt::registry& registry = _updateFramework.registry;
+    DirtyConnectionsSingleton& dirtyConnectionsSingleton = registry.ctx<DirtyConnectionsSingleton>();
+    ConnectionHandleTable& connectionHandles = registry.ctx<ConnectionHandleTable>();
+
+    _expiredTimers.clear();
+    _timerWheel.Advance(registry.ctx<TimeSingleton>().tickTimeNS, _expiredTimers);
+
+    for (const ExpiredTimer& expiredTimer : _expiredTimers)
     {
-        ZoneScopedNC("InternalPacketHandlerSystem::Update", tracy::Color::Blue2)
-        InternalPacketHandlerSystem::Update(registry);
-    });
+        ConnectionKind kind = expiredTimer.type == INTERNAL_PACKET_RETRY ? ConnectionKind::INTERNAL : ConnectionKind::CLIENT;
+        entt::entity entity = connectionHandles.Resolve(expiredTimer.data, kind);
+        if (entity == entt::null)
+            continue;
+
+        if (expiredTimer.type == HANDSHAKE_DEADLINE || expiredTimer.type == SESSION_EXPIRY)
+        {
+            _expiredConnections.push_back(entity);
+        }
+        else if (expiredTimer.type == CLIENT_PACKET_RETRY)
+        {
+            MarkConnectionDirty(registry.get<ConnectionComponent>(entity), entity, dirtyConnectionsSingleton.clientConnections);
+        }
+        else if (expiredTimer.type == INTERNAL_PACKET_RETRY)
+        {
+            MarkConnectionDirty(registry.get<InternalConnectionComponent>(entity), entity, dirtyConnectionsSingleton.internalConnections);
+        }
+    }
+
+    if (_expiredConnections.empty())
+        return;
+
+    // The network library reports the closed socket as a disconnect, which then finds the connection already gone
+    for (entt::entity entity : _expiredConnections)
+    {
+        ConnectionCloser::Close(*registry.get<ConnectionComponent>(entity).connection);
+        DestroyConnection(entity);
+    }
+
+    Metrics::Increment(MetricCounter::CONNECTIONS_TIMED_OUT, _expiredConnections.size());
+    NC_ASYNC_LOG_MESSAGE("Shard %u: disconnected %u connections that timed out", _shardIndex, static_cast<u32>(_expiredConnections.size()));
+    _expiredConnections.clear();
+}
+
+void EngineLoop::DestroyConnection(entt::entity entity)
+{
+    entt::registry& registry = _updateFramework.registry;
+    ConnectionHandleTable& connectionHandles = registry.ctx<ConnectionHandleTable>();
+
+    // Return packets that never got handled to the pool before the queues go away
+    Packet* packet;
+    if (ConnectionComponent* connectionComponent = registry.try_get<ConnectionComponent>(entity))
+    {
+        connectionHandles.Destroy(connectionComponent->identity);
+
+        while (connectionComponent->packetQueue.TryPop(packet))
+            PacketPool::Release(packet);
+
+        _timerWheel.Cancel(connectionComponent->expiryTimer);
+        _timerWheel.Cancel(connectionComponent->retryTimer);
+
+        // World servers stop accepting the session once its client is gone, unless the account logged in again on another connection
+        AccountComponent* accountComponent = registry.try_get<AccountComponent>(entity);
+        if (connectionComponent->authentication.stage == AuthenticationStage::AUTHENTICATED && accountComponent)
+            ServiceLocator::GetSessionKeyStore()->RemoveIfMatches(accountComponent->record.id, connectionComponent->authentication.sessionKey);
+    }
+    if (InternalConnectionComponent* internalConnectionComponent = registry.try_get<InternalConnectionComponent>(entity))
+    {
+        connectionHandles.Destroy(internalConnectionComponent->identity);
+
+        while (internalConnectionComponent->packetQueue.TryPop(packet))
+            PacketPool::Release(packet);
+
+        _timerWheel.Cancel(internalConnectionComponent->retryTimer);
+        ServiceLocator::GetRealmRegistry()->Remove(internalConnectionComponent->identity);
+    }
+
+    registry.destroy(entity);
+    Metrics::Increment(MetricCounter::CONNECTIONS_CLOSED);
+}
+
+void EngineLoop::HandlePasswordProofResults(const PasswordProofBatchResult& batchResult)
+{
+    ServiceLocator::GetCryptoWorkerPool()->RecordCompletion(batchResult);
+
+    entt::registry& registry = _updateFramework.registry;
+    ConnectionHandleTable& connectionHandles = registry.ctx<ConnectionHandleTable>();
+    for (const PasswordProofResult& result : batchResult.results)
+    {
+        // The connection might have disconnected while its proof was verified
+        entt::entity entity = connectionHandles.Resolve(result.identity, ConnectionKind::CLIENT);
+        if (entity == entt::null)
+            continue;
+
+        // Or its handshake gave up waiting for it
+        ConnectionComponent* connectionComponent = &registry.get<ConnectionComponent>(entity);
+        if (connectionComponent->authentication.stage != AuthenticationStage::VERIFYING_PROOF)
+            continue;
+        connectionComponent->authentication.stage = result.verified ? AuthenticationStage::AUTHENTICATED : AuthenticationStage::FAILED;
+        connectionComponent->authentication.isResultPending = true;
+        WakeConnection(entity, *connectionComponent);
+
+        // Only failed proofs count against the account, so knowing its name isn't enough to lock it out
+        AccountComponent* accountComponent = registry.try_get<AccountComponent>(entity);
+        if (!result.verified && accountComponent)
+        {
+            u64 nowNS = registry.ctx<TimeSingleton>().tickTimeNS;
+            if (ServiceLocator::GetAccountRateLimiter()->RecordFailedLogin(accountComponent->record.name, nowNS) == RateLimitResult::BANNED)
+                NC_ASYNC_LOG_WARNING("Shard %u: banned an account after too many failed logins", _shardIndex);
+        }
+
+        // The handshake deadline no longer applies, the session expires on its own schedule
+        if (result.verified)
+        {
+            u64 nowNS = registry.ctx<TimeSingleton>().tickTimeNS;
+            u64 expiresAtNS = nowNS + _sessionTimeout.count() * 1000000000ull;
+
+            _timerWheel.Cancel(connectionComponent->expiryTimer);
+            connectionComponent->expiryTimer = _timerWheel.Schedule(expiresAtNS, SESSION_EXPIRY, connectionComponent->identity);
+
+            // World servers validate the client against this key until the session expires
+            std::array<u8, 32>& sessionKey = connectionComponent->authentication.sessionKey;
+            GenerateRandomBytes(sessionKey);
+
+            if (accountComponent)
+            {
+                ServiceLocator::GetSessionKeyStore()->Insert(accountComponent->record.id, sessionKey, expiresAtNS, nowNS);
+            }
+        }
+    }
 }
-void EngineLoop::SetupClientMessageHandler()
+
+void EngineLoop::GenerateRandomBytes(std::array<u8, 32>& bytes)
 {
-    auto messageHandler = new MessageHandler();
+    for (size_t i = 0; i < bytes.size(); i += sizeof(u32))
+    {
+        u32 value = _randomDevice();
+        memcpy(&bytes[i], &value, sizeof(u32));
+    }
+}
+
+void EngineLoop::AssignQueuedClients()
+{
+    ZoneScopedNC("AssignQueuedClients", tracy::Color::Green3)
+
+    // Load reports handled this tick may have made room on an instance for clients waiting in a realm's queue
+    entt::registry& registry = _updateFramework.registry;
+    RealmRegistry* realmRegistry = ServiceLocator::GetRealmRegistry();
 
+    _realmAssignments.clear();
+    realmRegistry->AssignQueued(_shardIndex, registry, _realmAssignments);
 
+    for (const RealmAssignment& assignment : _realmAssignments)
+    {
+        entt::entity entity = registry.ctx<ConnectionHandleTable>().Resolve(assignment.identity, ConnectionKind::CLIENT);
+        ConnectionComponent& connectionComponent = registry.get<ConnectionComponent>(entity);
+        connectionComponent.queuedRealmId = 0;
+        Metrics::Increment(MetricCounter::REALM_JOINS_ASSIGNED);
+
+        PacketWriter writer;
+        RealmRegistry::WriteJoinResult(writer, RealmJoinResult::ASSIGNED, assignment.realmId, assignment);
+        PacketSender::Send(*connectionComponent.connection, Opcode::SMSG_REALM_JOIN, writer);
+    }
 
-    ServiceLocator::SetClientMessageHandler(messageHandler);
+    // The queues are shared by every shard, only one of them reports their length
+    if (_shardIndex == 0)
+        Metrics::SetGauge(MetricGauge::REALM_QUEUE_LENGTH, realmRegistry->GetQueuedCount());
 }
-void EngineLoop::SetupServerMessageHandler()
+
+void EngineLoop::CompactDirtyConnections()
 {
-    auto messageHandler = new MessageHandler();
-    ServiceLocator::SetInternalMessageHandler(messageHandler);
+    ZoneScopedNC("CompactDirtyConnections", tracy::Color::Green3)
 
-    Server::GeneralHandlers::Setup(messageHandler);
+    // Drops connections the systems emptied last tick and connections waiting on a retry timer,
+    // connections that got new packets this tick have a non empty queue and stay
+    entt::registry& registry = _updateFramework.registry;
+    TimeSingleton& timeSingleton = registry.ctx<TimeSingleton>();
+    DirtyConnectionsSingleton& dirtyConnectionsSingleton = registry.ctx<DirtyConnectionsSingleton>();
+    RemoveCleanConnections<ConnectionComponent>(registry, dirtyConnectionsSingleton.clientConnections, _timerWheel, CLIENT_PACKET_RETRY, timeSingleton.tickTimeNS);
+    RemoveCleanConnections<InternalConnectionComponent>(registry, dirtyConnectionsSingleton.internalConnections, _timerWheel, INTERNAL_PACKET_RETRY, timeSingleton.tickTimeNS);
+}
+
+void EngineLoop::SetupUpdateFramework()
+{
+    tf::Framework& framework = _updateFramework.framework;
+    entt::registry& registry = _updateFramework.registry;
+
+    ServiceLocator::SetRegistry(_shardIndex, &registry);
+
+    // @TODO: Temporary fix to allow taskflow to run multiple tasks at the same time when using Entt to construct views
+    registry.prepare<ConnectionComponent>();
+    registry.prepare<InternalConnectionComponent>();
+    registry.prepare<AccountComponent>();
+
+    registry.set<DirtyConnectionsSingleton>();
+    registry.set<ConnectionHandleTable>(_shardIndex);
+
+    // PacketHandlerSystem
+    PacketHandlerShardSingleton& packetHandlerShardSingleton = registry.set<PacketHandlerShardSingleton>();
+    packetHandlerShardSingleton.shardCount = _packetHandlerShardCount;
+
+    std::pair<tf::Task, tf::Task> packetHandlerShardTasks = framework.parallel_for(0, static_cast<i32>(_packetHandlerShardCount), 1, [&registry](i32 shardIndex)
+    {
+        ZoneScopedNC("PacketHandlerSystem::UpdateShard", tracy::Color::Orange2)
+        PacketHandlerSystem::UpdateShard(registry, static_cast<u32>(shardIndex));
+    });
+
+    // InternalPacketHandlerSystem
+    std::pair<tf::Task, tf::Task> internalPacketHandlerShardTasks = framework.parallel_for(0, static_cast<i32>(_packetHandlerShardCount), 1, [&registry](i32 shardIndex)
+    {
+        ZoneScopedNC("InternalPacketHandlerSystem::UpdateShard", tracy::Color::Blue2)
+        InternalPacketHandlerSystem::UpdateShard(registry, static_cast<u32>(shardIndex));
+    });
 }
 void EngineLoop::UpdateSystems()
 {
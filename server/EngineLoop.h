@@ -23,11 +23,22 @@
 */
 #pragma once
 #include <NovusTypes.h>
-#include <Utils/Message.h>
 #include <Utils/StringUtils.h>
 #include <Utils/ConcurrentQueue.h>
+#include "Utils/EngineMessages.h"
+#include "Networking/RateLimiter.h"
+#include "Networking/RealmRegistry.h"
+#include "Utils/TimerWheel.h"
+#include "Utils/PacketCapture.h"
 #include <taskflow/taskflow.hpp>
 #include <entt.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <condition_variable>
 
 namespace tf
 {
@@ -36,48 +47,142 @@ class Framework;
 
 struct FrameworkRegistryPair
 {
+    FrameworkRegistryPair(u32 workerCount) : taskflow(workerCount) { }
+
     entt::registry registry;
     tf::Framework framework;
     tf::Taskflow taskflow;
 };
 
+enum class EngineLoopMode
+{
+    FIXED_TICK, // Update at exactly targetTickRate
+    EVENT_DRIVEN // Update as soon as messages arrive, targetTickRate becomes the minimum rate at which systems are ticked
+};
+
+// Every lane is drained up to its budget per tick, in this order
+enum class InputLane : u8
+{
+    CONTROL, // Exit, console and results from our own worker pools
+    INTERNAL, // Packets and disconnects of realm/world servers
+    CLIENT, // Packets and disconnects of clients
+    COUNT
+};
+
+class Timer;
+struct PasswordProofBatchResult;
+struct ConnectionComponent;
+// One engine shard, created and fed by an EngineLoopGroup. Owns the connections routed to it, see ConnectionIdentity
 class EngineLoop
 {
 public:
-    EngineLoop(f32 targetTickRate);
+    EngineLoop(f32 targetTickRate, EngineLoopMode mode, u32 shardIndex, u32 shardCount);
     ~EngineLoop();
 
     void Start();
     void Stop();
 
-    void PassMessage(Message& message);
-    bool TryGetMessage(Message& message);
+    void PassMessage(const EngineInputMessage& message);
+    bool TryGetMessage(EngineOutputMessage& message);
 
-    template <typename... Args>
-    void PrintMessage(std::string message, Args... args)
+    u32 GetShardIndex() const { return _shardIndex; }
+
+    // How often the EVENT_DRIVEN loop checks its queues while idle, PassMessage wakes it up directly so this only bounds a missed wakeup
+    void SetWakePollInterval(std::chrono::microseconds interval) { _wakePollInterval = interval; }
+
+    // Number of shards client connections are split into for the PacketHandlerSystem, has to be set before Start
+    void SetPacketHandlerShardCount(u32 shardCount) { _packetHandlerShardCount = std::max(shardCount, 1u); }
+
+    // How many messages of a lane Update handles per tick, has to be set before Start
+    void SetInputLaneBudget(InputLane lane, u32 messagesPerTick) { _inputLaneBudgets[static_cast<u32>(lane)] = messagesPerTick; }
+
+    // Past highWatermark client messages waiting to be handled new connections are closed, and so are connections that keep their
+    // packet queue full, until the backlog drains to lowWatermark. Has to be set before Start
+    void SetClientLaneWatermarks(u32 lowWatermark, u32 highWatermark)
     {
-        char str[256];
-        StringUtils::FormatString(str, sizeof(str), message.c_str(), args...);
+        _clientLaneLowWatermark = lowWatermark;
+        _clientLaneHighWatermark = highWatermark;
+    }
+
+    // Client packets that arrive while this many messages wait for the shard are shed right away, has to be set before Start
+    void SetInputQueueCapacity(u32 capacity) { _inputQueueCapacity = capacity; }
 
-        Message printMessage;
-        printMessage.code = MSG_OUT_PRINT;
-        printMessage.message = new std::string(str);
+    // Client connections that haven't authenticated within handshakeTimeout, or were authenticated longer than sessionTimeout ago,
+    // are disconnected. Have to be set before Start
+    void SetHandshakeTimeout(std::chrono::seconds handshakeTimeout) { _handshakeTimeout = handshakeTimeout; }
+    void SetSessionTimeout(std::chrono::seconds sessionTimeout) { _sessionTimeout = sessionTimeout; }
+
+    // Limits packets per remote address, has to be set before Start. The account limits are shared, see EngineLoopGroup::SetRateLimiterConfig
+    void SetRateLimiterConfig(const RateLimiterConfig& config) { _rateLimiter = RateLimiter(config); }
+
+    // Replies to the console, everything else is logged through the AsyncLogger
+    template <typename... Args>
+    void PrintMessage(const char* format, Args... args)
+    {
+        EngineOutputMessage printMessage(EngineOutputType::PRINT);
+        StringUtils::FormatString(printMessage.text, sizeof(printMessage.text), format, args...);
         _outputQueue.enqueue(printMessage);
     }
 
 private:
     void Run();
     bool Update();
+    void SortInputQueue();
+    InputLane GetInputLane(const EngineInputMessage& message);
+    bool ShouldShed(const EngineInputMessage& message);
+    bool DrainInputLane(std::deque<EngineInputMessage>& lane, u32 budget);
+    bool HandleMessage(const EngineInputMessage& message);
+    void LogDroppedPackets();
+    void UpdateTimers();
+    void WakeConnection(entt::entity entity, ConnectionComponent& connectionComponent);
+    void DestroyConnection(entt::entity entity);
     void UpdateSystems();
+    void CompactDirtyConnections();
+    void HandleAccountQueryResults();
+    void HandlePasswordProofResults(const PasswordProofBatchResult& batchResult);
+    void GenerateRandomBytes(std::array<u8, 32>& bytes);
+    void AssignQueuedClients();
+    void WaitForTickRate(Timer& timer, f32 targetDelta);
+    void WaitForWork(Timer& timer, f32 maxDelta);
 
     void SetupUpdateFramework();
-    void SetupClientMessageHandler();
-    void SetupServerMessageHandler();
 private:
+    u32 _shardIndex;
     bool _isRunning;
+    bool _isShedding;
     f32 _targetTickRate;
+    EngineLoopMode _mode;
+
+    std::mutex _wakeMutex;
+    std::condition_variable _wakeCondition;
+    bool _wakeRequested;
+    std::chrono::microseconds _wakePollInterval;
+    u32 _packetHandlerShardCount;
+    std::random_device _randomDevice; // Session keys and handshake nonces, only used on the engine thread
+
+    u32 _inputLaneBudgets[static_cast<u32>(InputLane::COUNT)];
+    u32 _clientLaneLowWatermark;
+    u32 _clientLaneHighWatermark;
+    u32 _inputQueueCapacity;
+    RateLimiter _rateLimiter;
+
+    std::chrono::seconds _handshakeTimeout;
+    std::chrono::seconds _sessionTimeout;
+    TimerWheel _timerWheel;
+    std::vector<ExpiredTimer> _expiredTimers;
+    std::vector<entt::entity> _expiredConnections;
+    std::vector<RealmAssignment> _realmAssignments;
+    u32 _droppedPacketCount;
+    u64 _droppedPacketsLoggedAtNS;
+    u32 _closedConnectionCount; // Serial of the identities ShouldShed tags connections with
+
+    PacketCaptureRecorder _packetCaptureRecorder;
+    bool _isCapturingPackets;
 
-    moodycamel::ConcurrentQueue<Message> _inputQueue;
-    moodycamel::ConcurrentQueue<Message> _outputQueue;
+    moodycamel::ConcurrentQueue<EngineInputMessage> _inputQueue; // Filled by the EngineLoopGroup router, a tick's worth is sorted into the lanes every tick
+    moodycamel::ConcurrentQueue<EngineInputMessage> _controlQueue;
+    std::deque<EngineInputMessage> _internalLane;
+    std::deque<EngineInputMessage> _clientLane;
+    moodycamel::ConcurrentQueue<EngineOutputMessage> _outputQueue;
     FrameworkRegistryPair _updateFramework;
 };
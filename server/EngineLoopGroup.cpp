@@ -0,0 +1,233 @@
+#include "EngineLoopGroup.h"
+#include <Networking/InputQueue.h>
+#include <Networking/Connection.h>
+#include <Networking/Packet.h>
+#include "Utils/ServiceLocator.h"
+#include "Utils/AsyncLogger.h"
+#include "Database/AccountQueryService.h"
+#include "Database/InMemoryAccountBackend.h"
+#include "Database/SessionKeyStore.h"
+#include "Cryptography/CryptoWorkerPool.h"
+#include "Networking/MessageHandler.h"
+#include "Networking/RateLimiter.h"
+#include "Networking/RealmRegistry.h"
+#include "Networking/ConnectionIdentity.h"
+#include <tracy/Tracy.hpp>
+#include <algorithm>
+
+// Handlers
+#include "Networking/Handlers/Client/GeneralHandlers.h"
+#include "Networking/Handlers/Server/GeneralHandlers.h"
+
+EngineLoopGroup::EngineLoopGroup(u32 shardCount, f32 targetTickRate, EngineLoopMode mode)
+    : _isRunning(false), _accountQueryWorkerCount(2), _cryptoWorkerCount(2), _cryptoMaxQueuedJobs(4096), _sessionKeyStoreCapacity(65536),
+      _inputQueue(256), _isRouting(false), _routeRequested(false), _routePollInterval(1000), _nextOutputShard(0), _exitedShardCount(0)
+{
+    shardCount = std::min(std::max(shardCount, 1u), ServiceLocator::MAX_ENGINE_SHARDS);
+    for (u32 i = 0; i < shardCount; i++)
+    {
+        _shards.push_back(std::make_unique<EngineLoop>(targetTickRate, mode, i, shardCount));
+    }
+}
+
+EngineLoopGroup::~EngineLoopGroup()
+{
+    if (_routeThread.joinable())
+    {
+        _isRouting = false;
+        _routeCondition.notify_one();
+        _routeThread.join();
+    }
+
+    // The workers post their results to the shards, they have to be gone before the shards are
+    StopWorkerPools();
+    if (_isRunning)
+        ServiceLocator::Reset();
+}
+
+void EngineLoopGroup::Start()
+{
+    if (_isRunning)
+        return;
+
+    _isRunning = true;
+    SetupServices();
+
+    // Setup Network Lib
+    InputQueue::SetInputQueue(&_inputQueue);
+
+    for (std::unique_ptr<EngineLoop>& shard : _shards)
+    {
+        shard->SetRateLimiterConfig(_rateLimiterConfig);
+        shard->Start();
+    }
+
+    _isRouting = true;
+    _routeThread = std::thread(&EngineLoopGroup::RouteRun, this);
+}
+
+void EngineLoopGroup::Stop()
+{
+    if (!_isRunning)
+        return;
+
+    Broadcast(EngineInputMessage(EngineInputType::EXIT));
+}
+
+void EngineLoopGroup::PassMessage(Message& message)
+{
+    // Network messages take the same path as the ones from the network library so they keep their order
+    if (message.code == MSG_IN_NET_PACKET || message.code == MSG_IN_INTERNAL_NET_PACKET || message.code == MSG_IN_NET_DISCONNECT)
+    {
+        _inputQueue.enqueue(message);
+
+        {
+            std::lock_guard<std::mutex> lock(_routeMutex);
+            _routeRequested = true;
+        }
+        _routeCondition.notify_one();
+        return;
+    }
+
+    EngineInputMessage engineMessage = EngineInputMessage::FromMessage(message);
+    if (engineMessage.type != EngineInputType::NONE)
+        Broadcast(engineMessage);
+}
+
+bool EngineLoopGroup::TryGetMessage(EngineOutputMessage& message)
+{
+    // Take turns so one busy shard can't hide the output of the others
+    u32 shardCount = GetShardCount();
+    for (u32 i = 0; i < shardCount; i++)
+    {
+        EngineLoop& shard = *_shards[_nextOutputShard];
+        _nextOutputShard = (_nextOutputShard + 1) % shardCount;
+
+        if (!shard.TryGetMessage(message))
+            continue;
+
+        if (message.type == EngineOutputType::EXIT_CONFIRM)
+        {
+            if (++_exitedShardCount < shardCount)
+                continue;
+
+            // No shard submits work anymore
+            StopWorkerPools();
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void EngineLoopGroup::SetupServices()
+{
+    u32 shardCount = GetShardCount();
+
+    _clientMessageHandler = std::make_unique<MessageHandler>();
+    ServiceLocator::SetClientMessageHandler(_clientMessageHandler.get());
+    Client::GeneralHandlers::Setup(_clientMessageHandler.get());
+
+    _internalMessageHandler = std::make_unique<MessageHandler>();
+    ServiceLocator::SetInternalMessageHandler(_internalMessageHandler.get());
+    Server::GeneralHandlers::Setup(_internalMessageHandler.get());
+
+    // @TODO: Replace with a database backed AccountBackend
+    std::unique_ptr<InMemoryAccountBackend> accountBackend = std::make_unique<InMemoryAccountBackend>();
+    u32 accountCount = 0;
+    if (_accountsFile.empty() || !accountBackend->LoadFromFile(_accountsFile, accountCount))
+        NC_ASYNC_LOG_WARNING("No accounts file could be loaded, every login will fail with an unknown account");
+    else
+        NC_ASYNC_LOG_MESSAGE("Loaded %u accounts", accountCount);
+
+    _accountQueryService = std::make_unique<AccountQueryService>(std::move(accountBackend), _accountQueryWorkerCount, shardCount);
+    _cryptoWorkerPool = std::make_unique<CryptoWorkerPool>(this, _cryptoWorkerCount, _cryptoMaxQueuedJobs);
+    _sessionKeyStore = std::make_unique<SessionKeyStore>(_sessionKeyStoreCapacity);
+    _accountRateLimiter = std::make_unique<AccountRateLimiter>(_rateLimiterConfig);
+    _realmRegistry = std::make_unique<RealmRegistry>();
+    _packetCaptureWriter = std::make_unique<PacketCaptureWriter>();
+
+    ServiceLocator::SetAccountQueryService(_accountQueryService.get());
+    ServiceLocator::SetCryptoWorkerPool(_cryptoWorkerPool.get());
+    ServiceLocator::SetSessionKeyStore(_sessionKeyStore.get());
+    ServiceLocator::SetAccountRateLimiter(_accountRateLimiter.get());
+    ServiceLocator::SetRealmRegistry(_realmRegistry.get());
+    ServiceLocator::SetPacketCaptureWriter(_packetCaptureWriter.get());
+}
+
+void EngineLoopGroup::StopWorkerPools()
+{
+    // Joins their threads, work that was still queued is dropped. The services stay reachable so late stats calls still find them
+    if (_cryptoWorkerPool)
+        _cryptoWorkerPool->Stop();
+    if (_accountQueryService)
+        _accountQueryService->Stop();
+}
+
+void EngineLoopGroup::Broadcast(const EngineInputMessage& message)
+{
+    for (std::unique_ptr<EngineLoop>& shard : _shards)
+    {
+        shard->PassMessage(message);
+    }
+}
+
+void EngineLoopGroup::RouteRun()
+{
+    constexpr size_t ROUTE_BATCH_SIZE = 64;
+    Message messages[ROUTE_BATCH_SIZE];
+
+    while (_isRouting)
+    {
+        size_t count = _inputQueue.try_dequeue_bulk(messages, ROUTE_BATCH_SIZE);
+        if (count == 0)
+        {
+            // The network library enqueues without signalling us, so an idle router still checks every _routePollInterval
+            std::unique_lock<std::mutex> lock(_routeMutex);
+            if (!_routeRequested && _inputQueue.size_approx() == 0)
+                _routeCondition.wait_for(lock, _routePollInterval);
+
+            _routeRequested = false;
+            continue;
+        }
+
+        ZoneScopedNC("EngineLoopGroup::Route", tracy::Color::Green3)
+
+        // A capture is stamped here instead of when a shard gets to the message, a shard that's behind would squash the recorded pacing
+        PacketCaptureWriter* packetCaptureWriter = ServiceLocator::GetPacketCaptureWriter();
+        bool isCapturingPackets = packetCaptureWriter && packetCaptureWriter->IsCapturing();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            // The only conversion a network message goes through, past here the shards' queues never allocate
+            EngineInputMessage engineMessage = EngineInputMessage::FromMessage(messages[i]);
+            if (engineMessage.type == EngineInputType::NONE)
+                continue;
+
+            if (isCapturingPackets)
+                engineMessage.receivedNS = TimeSingleton::Now();
+
+            _shards[GetShardIndex(engineMessage)]->PassMessage(engineMessage);
+        }
+    }
+}
+
+u32 EngineLoopGroup::GetShardIndex(const EngineInputMessage& message)
+{
+    u32 shardCount = GetShardCount();
+    if (shardCount == 1)
+        return 0;
+
+    // A disconnect of a connection no shard has seen yet has nothing to clean up, any shard can throw it away
+    if (message.type == EngineInputType::DISCONNECT)
+        return message.identity ? ConnectionIdentity::GetShardIndex(message.identity) : 0;
+
+    Packet* packet = message.packet;
+    if (u64 identity = packet->connection->GetIdentity())
+        return ConnectionIdentity::GetShardIndex(identity);
+
+    // Every packet a new connection sends before its shard tagged it has to go to the same shard, so this may only depend on the connection
+    u64 addressKey = RateLimiter::GetAddressKey(*packet->connection);
+    return static_cast<u32>(addressKey % shardCount);
+}
@@ -0,0 +1,127 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Utils/Message.h>
+#include <Utils/ConcurrentQueue.h>
+#include "EngineLoop.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class MessageHandler;
+class AccountQueryService;
+class CryptoWorkerPool;
+class SessionKeyStore;
+class RealmRegistry;
+
+// Runs several EngineLoop shards side by side, every shard has its own thread, registry, queues and systems.
+// The group owns the queue the network library fills, a router thread hands every message to the shard that owns its connection:
+// connections that already have an identity carry their shard in it (see ConnectionIdentity), new connections are assigned by a hash
+// of their remote address so every connection from one address lands on the same shard and its rate limits stay exact.
+//
+// Services every shard shares (account lookups, password verification, account login limits, session keys and realms) are created by the group
+// before the shards start and are thread safe. The group owns them, the worker pools are shut down once every shard confirmed its exit
+// and the rest goes with the group, which may only be destroyed after that.
+class EngineLoopGroup
+{
+public:
+    EngineLoopGroup(u32 shardCount, f32 targetTickRate, EngineLoopMode mode = EngineLoopMode::FIXED_TICK);
+    ~EngineLoopGroup();
+
+    void Start();
+    void Stop();
+
+    // Takes messages in the network library's format, network messages go to the shard that owns their connection
+    // and every other message goes to every shard. See EngineInputMessage::FromMessage
+    void PassMessage(Message& message);
+
+    // Output of every shard, EXIT_CONFIRM is only returned once every shard has exited and the worker pools have been joined
+    bool TryGetMessage(EngineOutputMessage& message);
+
+    u32 GetShardCount() const { return static_cast<u32>(_shards.size()); }
+    EngineLoop& GetShard(u32 shardIndex) { return *_shards[shardIndex]; }
+
+    // Threads running account lookups against the AccountBackend, has to be set before Start
+    void SetAccountQueryWorkerCount(u32 workerCount) { _accountQueryWorkerCount = workerCount; }
+
+    // Accounts the in-memory AccountBackend is seeded with, see InMemoryAccountBackend::LoadFromFile. Has to be set before Start
+    void SetAccountsFile(const std::string& path) { _accountsFile = path; }
+
+    // Threads verifying login proofs and how many verifications may be queued for them, have to be set before Start
+    void SetCryptoWorkerCount(u32 workerCount) { _cryptoWorkerCount = workerCount; }
+    void SetCryptoMaxQueuedJobs(u32 maxQueuedJobs) { _cryptoMaxQueuedJobs = maxQueuedJobs; }
+
+    // How many session keys the SessionKeyStore holds before it starts evicting the ones closest to expiring, has to be set before Start
+    void SetSessionKeyStoreCapacity(u32 capacity) { _sessionKeyStoreCapacity = capacity; }
+
+    // Address limits go to every shard, account limits to the AccountRateLimiter they share. Has to be set before Start
+    void SetRateLimiterConfig(const RateLimiterConfig& config) { _rateLimiterConfig = config; }
+
+    // How often the router checks the network queue while idle, the network library enqueues without signalling us
+    void SetRoutePollInterval(std::chrono::microseconds interval) { _routePollInterval = interval; }
+
+private:
+    void SetupServices();
+    void StopWorkerPools();
+    void Broadcast(const EngineInputMessage& message);
+    void RouteRun();
+    u32 GetShardIndex(const EngineInputMessage& message);
+
+private:
+    std::vector<std::unique_ptr<EngineLoop>> _shards;
+    bool _isRunning;
+
+    std::unique_ptr<MessageHandler> _clientMessageHandler;
+    std::unique_ptr<MessageHandler> _internalMessageHandler;
+    std::unique_ptr<AccountQueryService> _accountQueryService;
+    std::unique_ptr<CryptoWorkerPool> _cryptoWorkerPool;
+    std::unique_ptr<SessionKeyStore> _sessionKeyStore;
+    std::unique_ptr<AccountRateLimiter> _accountRateLimiter;
+    std::unique_ptr<RealmRegistry> _realmRegistry;
+    std::unique_ptr<PacketCaptureWriter> _packetCaptureWriter;
+
+    u32 _accountQueryWorkerCount;
+    u32 _cryptoWorkerCount;
+    u32 _cryptoMaxQueuedJobs;
+    u32 _sessionKeyStoreCapacity;
+    RateLimiterConfig _rateLimiterConfig;
+    std::string _accountsFile;
+
+    moodycamel::ConcurrentQueue<Message> _inputQueue; // Filled by the network library, converted to EngineInputMessages by the router
+    std::thread _routeThread;
+    std::atomic<bool> _isRouting;
+    std::mutex _routeMutex;
+    std::condition_variable _routeCondition;
+    bool _routeRequested;
+    std::chrono::microseconds _routePollInterval;
+
+    u32 _nextOutputShard;
+    u32 _exitedShardCount;
+};
@@ -0,0 +1,18 @@
+#include "ConnectionCloser.h"
+#include <Networking/Connection.h>
+#include <asio/ip/tcp.hpp>
+#include <asio/post.hpp>
+
+void ConnectionCloser::Close(Connection& connection)
+{
+    asio::ip::tcp::socket* socket = connection.GetSocket();
+    if (!socket)
+        return;
+
+    asio::post(socket->get_executor(), [socket]()
+    {
+        asio::error_code errorCode;
+        socket->shutdown(asio::ip::tcp::socket::shutdown_both, errorCode);
+        socket->close(errorCode);
+    });
+}
@@ -0,0 +1,70 @@
+#include "ConnectionHandleTable.h"
+#include "ConnectionIdentity.h"
+
+u64 ConnectionHandleTable::Create(ConnectionKind kind, entt::entity entity)
+{
+    u32 index = _freeList;
+    if (index != INVALID_INDEX)
+    {
+        _freeList = _slots[index].nextFree;
+    }
+    else
+    {
+        index = static_cast<u32>(_slots.size());
+        _slots.emplace_back();
+    }
+
+    Slot& slot = _slots[index];
+    slot.entity = entity;
+    slot.kind = kind;
+    slot.nextFree = INVALID_INDEX;
+
+    _activeCount++;
+    return ConnectionIdentity::Make(_shardIndex, index, slot.generation);
+}
+
+bool ConnectionHandleTable::Destroy(u64 identity)
+{
+    // Destroying twice must not free the slot of whichever connection reused it
+    if (!Find(identity))
+        return false;
+
+    u32 index = ConnectionIdentity::GetIndex(identity);
+    Slot& slot = _slots[index];
+    slot.entity = entt::null;
+    slot.kind = ConnectionKind::NONE;
+    slot.generation = (slot.generation + 1) & ConnectionIdentity::GENERATION_MASK;
+    slot.nextFree = _freeList;
+    _freeList = index;
+
+    _activeCount--;
+    return true;
+}
+
+entt::entity ConnectionHandleTable::Resolve(u64 identity, ConnectionKind kind) const
+{
+    const Slot* slot = Find(identity);
+    if (!slot || slot->kind != kind)
+        return entt::null;
+
+    return slot->entity;
+}
+
+ConnectionKind ConnectionHandleTable::GetKind(u64 identity) const
+{
+    const Slot* slot = Find(identity);
+    return slot ? slot->kind : ConnectionKind::NONE;
+}
+
+const ConnectionHandleTable::Slot* ConnectionHandleTable::Find(u64 identity) const
+{
+    u32 index = ConnectionIdentity::GetIndex(identity);
+    if (identity == 0 || ConnectionIdentity::GetShardIndex(identity) != _shardIndex || index >= _slots.size())
+        return nullptr;
+
+    const Slot& slot = _slots[index];
+    if (slot.kind == ConnectionKind::NONE || slot.generation != ConnectionIdentity::GetGeneration(identity))
+        return nullptr;
+
+    return &slot;
+}
@@ -0,0 +1,73 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <entt.hpp>
+#include <vector>
+
+enum class ConnectionKind : u8
+{
+    NONE, // Free slot
+    CLIENT,
+    INTERNAL
+};
+
+// Dense table of the connections an engine shard owns, the ConnectionIdentity a connection is tagged with indexes straight into it.
+// Every slot carries a generation that is bumped when its connection is destroyed, so an identity that outlived its connection
+// (packets still in flight after a disconnect, late results of a worker pool, timers) resolves to entt::null instead of to whatever
+// connection reused the slot. Resolving also checks the kind, a client identity never resolves to an internal connection.
+// Create and Destroy are called by the owning EngineLoop only, Resolve may be called by its systems while they run.
+class ConnectionHandleTable
+{
+public:
+    ConnectionHandleTable(u32 shardIndex) : _shardIndex(shardIndex), _freeList(INVALID_INDEX), _activeCount(0) { }
+
+    u64 Create(ConnectionKind kind, entt::entity entity);
+    bool Destroy(u64 identity);
+
+    // O(1), entt::null if the connection is gone, belongs to another shard or is of another kind
+    entt::entity Resolve(u64 identity, ConnectionKind kind) const;
+    ConnectionKind GetKind(u64 identity) const;
+
+    u32 GetActiveCount() const { return _activeCount; }
+
+private:
+    static constexpr u32 INVALID_INDEX = 0xFFFFFFFF;
+
+    struct Slot
+    {
+        entt::entity entity = entt::null;
+        u32 generation = 0;
+        u32 nextFree = INVALID_INDEX;
+        ConnectionKind kind = ConnectionKind::NONE;
+    };
+
+    const Slot* Find(u64 identity) const;
+
+private:
+    u32 _shardIndex;
+    u32 _freeList;
+    u32 _activeCount;
+    std::vector<Slot> _slots;
+};
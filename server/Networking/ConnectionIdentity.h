@@ -0,0 +1,50 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+
+// The identity the EngineLoop tags a connection with, a handle into the ConnectionHandleTable of the shard that owns it:
+// the shard in the upper 8 bits, stored as shard index + 1 so no identity is ever 0, the generation of the table slot in the next 24 bits
+// and the index of the slot in the lower 32 bits.
+// An identity of 0 means the connection hasn't been seen by any shard yet.
+class ConnectionIdentity
+{
+public:
+    static constexpr u32 GENERATION_BITS = 24;
+    static constexpr u32 GENERATION_MASK = (1u << GENERATION_BITS) - 1;
+    static constexpr u32 CLOSED_INDEX = 0xFFFFFFFF; // Never handed out by a ConnectionHandleTable
+
+    static u64 Make(u32 shardIndex, u32 index, u32 generation)
+    {
+        return (static_cast<u64>(shardIndex + 1) << 56) | (static_cast<u64>(generation & GENERATION_MASK) << 32) | index;
+    }
+
+    // Tags a connection the shard turned away, it resolves to nothing so the rest of its packets are dropped as stale.
+    // The serial keeps the identities of closed connections apart so their disconnects can be told apart, it wraps at the generation bits
+    static u64 MakeClosed(u32 shardIndex, u32 serial) { return Make(shardIndex, CLOSED_INDEX, serial); }
+
+    static u32 GetShardIndex(u64 identity) { return static_cast<u32>(identity >> 56) - 1; }
+    static u32 GetGeneration(u64 identity) { return static_cast<u32>(identity >> 32) & GENERATION_MASK; }
+    static u32 GetIndex(u64 identity) { return static_cast<u32>(identity); }
+};
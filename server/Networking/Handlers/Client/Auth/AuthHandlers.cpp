@@ -1,3 +1,169 @@
 #include "AuthHandlers.h"
+#include "../../../MessageHandler.h"
+#include "../../../ConnectionHandleTable.h"
+#include "../../../PacketSender.h"
+#include "../../../../Utils/ServiceLocator.h"
+#include "../../../../Database/AccountQueryService.h"
+#include "../../../../Cryptography/CryptoWorkerPool.h"
+#include "../../../../ECS/Components/ConnectionComponent.h"
+#include "../../../../ECS/Components/AccountComponent.h"
+#include <Networking/Packet.h>
+#include <Utils/DebugHandler.h>
 
+namespace
+{
+    void SendHandshakeResult(Packet* packet, HandshakeResult result)
+    {
+        PacketWriter writer;
+        writer.Put<u8>(static_cast<u8>(result));
+        PacketSender::Send(*packet->connection, Opcode::SMSG_HANDSHAKE, writer);
+    }
 
+    // Answers the step that reached AUTHENTICATED or FAILED, whichever of the two handlers was waiting for it
+    void SendPendingResult(Packet* packet, entt::registry* registry, entt::entity entity, AuthenticationState& authentication)
+    {
+        authentication.isResultPending = false;
+        if (authentication.stage == AuthenticationStage::FAILED)
+        {
+            SendHandshakeResult(packet, HandshakeResult::INCORRECT_PROOF);
+            return;
+        }
+
+        PacketWriter writer;
+        writer.Put<u8>(static_cast<u8>(HandshakeResult::AUTHENTICATED));
+        writer.Put<u32>(registry->get<AccountComponent>(entity).record.id);
+        writer.PutBytes(authentication.sessionKey.data(), authentication.sessionKey.size());
+        PacketSender::Send(*packet->connection, Opcode::SMSG_HANDSHAKE, writer);
+    }
+}
+
+void Client::AuthHandlers::Setup(MessageHandler* messageHandler)
+{
+    messageHandler->SetMessageHandler(Opcode::CMSG_HANDSHAKE, Client::AuthHandlers::HandshakeHandler);
+    messageHandler->SetMessageHandler(Opcode::CMSG_HANDSHAKE_PROOF, Client::AuthHandlers::HandshakeProofHandler);
+}
+bool Client::AuthHandlers::HandshakeHandler(Packet* packet)
+{
+    u64 identity = packet->connection->GetIdentity();
+    entt::registry* registry = ServiceLocator::GetConnectionRegistry(identity);
+    entt::entity entity = registry->ctx<ConnectionHandleTable>().Resolve(identity, ConnectionKind::CLIENT);
+    if (entity == entt::null)
+        return true;
+
+    ConnectionComponent& connectionComponent = registry->get<ConnectionComponent>(entity);
+    AuthenticationState& authentication = connectionComponent.authentication;
+
+    // A handshake that doesn't find its own attempt waiting for a step is a new attempt
+    if (!authentication.isResultPending)
+    {
+        // Logging in again doesn't get to skip the proof
+        if (authentication.stage == AuthenticationStage::AUTHENTICATED)
+        {
+            SendHandshakeResult(packet, HandshakeResult::ALREADY_AUTHENTICATED);
+            return true;
+        }
+
+        if (authentication.stage == AuthenticationStage::AWAITING_PROOF || authentication.stage == AuthenticationStage::FAILED)
+            authentication.stage = AuthenticationStage::NONE;
+    }
+
+    // Every step that has to wait returns false, the EngineLoop wakes the connection up again once that step has completed
+    switch (authentication.stage)
+    {
+        case AuthenticationStage::NONE:
+        {
+            std::string accountName;
+            if (!packet->payload->GetString(accountName) || accountName.empty())
+                return true;
+
+            authentication.stage = AuthenticationStage::ACCOUNT_LOOKUP;
+            authentication.isAccountLoaded = false;
+            ServiceLocator::GetAccountQueryService()->LookupAccountByName(identity, accountName);
+            return false;
+        }
+        case AuthenticationStage::ACCOUNT_LOOKUP:
+        {
+            // An earlier attempt may have left its AccountComponent behind
+            if (!authentication.isAccountLoaded)
+                return false;
+
+            AccountComponent& accountComponent = registry->get<AccountComponent>(entity);
+            if (!accountComponent.found)
+            {
+                authentication.stage = AuthenticationStage::FAILED;
+                SendHandshakeResult(packet, HandshakeResult::UNKNOWN_ACCOUNT);
+                return true;
+            }
+
+            // The nonce was generated along with loading the account, the proof has to be made for it
+            authentication.stage = AuthenticationStage::AWAITING_PROOF;
+            authentication.isProofReceived = false;
+
+            PacketWriter writer;
+            writer.Reserve(1 + accountComponent.record.salt.size() + authentication.serverNonce.size());
+            writer.Put<u8>(static_cast<u8>(HandshakeResult::CHALLENGE));
+            writer.PutBytes(accountComponent.record.salt.data(), accountComponent.record.salt.size());
+            writer.PutBytes(authentication.serverNonce.data(), authentication.serverNonce.size());
+            PacketSender::Send(*packet->connection, Opcode::SMSG_HANDSHAKE, writer);
+            return true;
+        }
+        case AuthenticationStage::AWAITING_PROOF:
+            return true;
+
+        case AuthenticationStage::VERIFYING_PROOF:
+            return false;
+
+        case AuthenticationStage::AUTHENTICATED:
+        case AuthenticationStage::FAILED:
+            SendPendingResult(packet, registry, entity, authentication);
+            return true;
+    }
+
+    return true;
+}
+bool Client::AuthHandlers::HandshakeProofHandler(Packet* packet)
+{
+    u64 identity = packet->connection->GetIdentity();
+    entt::registry* registry = ServiceLocator::GetConnectionRegistry(identity);
+    entt::entity entity = registry->ctx<ConnectionHandleTable>().Resolve(identity, ConnectionKind::CLIENT);
+    if (entity == entt::null)
+        return true;
+
+    ConnectionComponent& connectionComponent = registry->get<ConnectionComponent>(entity);
+    AuthenticationState& authentication = connectionComponent.authentication;
+
+    if (authentication.isResultPending)
+    {
+        SendPendingResult(packet, registry, entity, authentication);
+        return true;
+    }
+
+    if (authentication.stage == AuthenticationStage::VERIFYING_PROOF)
+        return false;
+
+    // A proof only answers the challenge of the attempt in progress
+    if (authentication.stage != AuthenticationStage::AWAITING_PROOF)
+        return true;
+
+    // Read once, a retry while the pool is saturated finds the proof already taken from the payload
+    if (!authentication.isProofReceived)
+    {
+        if (!packet->payload->GetBytes(authentication.clientProof.data(), authentication.clientProof.size()))
+            return true;
+
+        authentication.isProofReceived = true;
+    }
+
+    PasswordProofJob job;
+    job.identity = identity;
+    job.serverNonce = authentication.serverNonce;
+    job.verifier = registry->get<AccountComponent>(entity).record.verifier;
+    job.clientProof = authentication.clientProof;
+
+    // The pool is saturated, try again after the retry backoff
+    if (!ServiceLocator::GetCryptoWorkerPool()->TrySubmit(job))
+        return false;
+
+    authentication.stage = AuthenticationStage::VERIFYING_PROOF;
+    return false;
+}
@@ -1,8 +1,14 @@
 #pragma once
 
+class MessageHandler;
 struct Packet;
-struct ConnectionComponent;
-class AuthHandlers
+namespace Client
 {
-    static void HandshakeHandler(Packet*, ConnectionComponent*);
-};
\ No newline at end of file
+    class AuthHandlers
+    {
+    public:
+        static void Setup(MessageHandler*);
+        static bool HandshakeHandler(Packet*);
+        static bool HandshakeProofHandler(Packet*);
+    };
+}
\ No newline at end of file
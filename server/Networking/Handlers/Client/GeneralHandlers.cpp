@@ -0,0 +1,11 @@
+#include "GeneralHandlers.h"
+#include "../../MessageHandler.h"
+#include "Auth/AuthHandlers.h"
+#include "Realm/RealmHandlers.h"
+
+void Client::GeneralHandlers::Setup(MessageHandler* messageHandler)
+{
+    // Setup other handlers
+    AuthHandlers::Setup(messageHandler);
+    RealmHandlers::Setup(messageHandler);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+class MessageHandler;
+struct Packet;
+namespace Client
+{
+    class GeneralHandlers
+    {
+    public:
+        static void Setup(MessageHandler*);
+    };
+}
\ No newline at end of file
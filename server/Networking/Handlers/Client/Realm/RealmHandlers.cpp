@@ -0,0 +1,87 @@
+#include "RealmHandlers.h"
+#include "../../../MessageHandler.h"
+#include "../../../RealmRegistry.h"
+#include "../../../PacketSender.h"
+#include "../../../ConnectionHandleTable.h"
+#include "../../../../Utils/ServiceLocator.h"
+#include "../../../../Utils/Metrics.h"
+#include "../../../../ECS/Components/ConnectionComponent.h"
+#include <Networking/Packet.h>
+
+void Client::RealmHandlers::Setup(MessageHandler* messageHandler)
+{
+    messageHandler->SetMessageHandler(Opcode::CMSG_REALM_LIST, Client::RealmHandlers::RealmListHandler);
+    messageHandler->SetMessageHandler(Opcode::CMSG_REALM_JOIN, Client::RealmHandlers::RealmJoinHandler);
+}
+bool Client::RealmHandlers::RealmListHandler(Packet* packet)
+{
+    u64 identity = packet->connection->GetIdentity();
+    entt::registry* registry = ServiceLocator::GetConnectionRegistry(identity);
+    entt::entity entity = registry->ctx<ConnectionHandleTable>().Resolve(identity, ConnectionKind::CLIENT);
+    if (entity == entt::null)
+        return true;
+
+    ConnectionComponent& connectionComponent = registry->get<ConnectionComponent>(entity);
+
+    if (connectionComponent.authentication.stage != AuthenticationStage::AUTHENTICATED)
+        return true;
+
+    // The list is serialized once per change, every client is sent the same buffer
+    PacketSender::Send(*packet->connection, Opcode::SMSG_REALM_LIST, ServiceLocator::GetRealmRegistry()->GetRealmList());
+    return true;
+}
+bool Client::RealmHandlers::RealmJoinHandler(Packet* packet)
+{
+    u64 identity = packet->connection->GetIdentity();
+    entt::registry* registry = ServiceLocator::GetConnectionRegistry(identity);
+    entt::entity entity = registry->ctx<ConnectionHandleTable>().Resolve(identity, ConnectionKind::CLIENT);
+    if (entity == entt::null)
+        return true;
+
+    ConnectionComponent& connectionComponent = registry->get<ConnectionComponent>(entity);
+
+    if (connectionComponent.authentication.stage != AuthenticationStage::AUTHENTICATED)
+        return true;
+
+    u32 realmId = 0;
+    if (!packet->payload->GetU32(realmId))
+        return true;
+
+    // Already waiting for this realm, the EngineLoop sends the assignment once an instance has room
+    RealmAssignment assignment;
+    if (connectionComponent.queuedRealmId == realmId)
+    {
+        PacketWriter writer;
+        RealmRegistry::WriteJoinResult(writer, RealmJoinResult::QUEUED, realmId, assignment);
+        PacketSender::Send(*packet->connection, Opcode::SMSG_REALM_JOIN, writer);
+        return true;
+    }
+
+    // Entries an earlier join left in another queue, or in this one, are dropped instead of assigned
+    connectionComponent.realmJoinSerial++;
+
+    RealmJoinResult result = ServiceLocator::GetRealmRegistry()->JoinRealm(identity, realmId, connectionComponent.realmJoinSerial, assignment);
+    switch (result)
+    {
+        case RealmJoinResult::ASSIGNED:
+            connectionComponent.queuedRealmId = 0;
+            Metrics::Increment(MetricCounter::REALM_JOINS_ASSIGNED);
+            break;
+
+        case RealmJoinResult::QUEUED:
+            connectionComponent.queuedRealmId = realmId;
+            Metrics::Increment(MetricCounter::REALM_JOINS_QUEUED);
+            break;
+
+        case RealmJoinResult::UNKNOWN_REALM:
+            connectionComponent.queuedRealmId = 0;
+            break;
+    }
+
+    // A queued client is sent another SMSG_REALM_JOIN by the EngineLoop once it gets assigned
+    PacketWriter writer;
+    RealmRegistry::WriteJoinResult(writer, result, realmId, assignment);
+    PacketSender::Send(*packet->connection, Opcode::SMSG_REALM_JOIN, writer);
+
+    return true;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+class MessageHandler;
+struct Packet;
+namespace Client
+{
+    class RealmHandlers
+    {
+    public:
+        static void Setup(MessageHandler*);
+        static bool RealmListHandler(Packet*);
+        static bool RealmJoinHandler(Packet*);
+    };
+}
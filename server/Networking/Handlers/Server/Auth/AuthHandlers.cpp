@@ -1,23 +1,58 @@
 #include "AuthHandlers.h"
 #include "../../../MessageHandler.h"
-
-// @TODO: Remove Temporary Includes when they're no longer needed
-#include <Utils\DebugHandler.h>
+#include "../../../RealmRegistry.h"
+#include "../../../PacketSender.h"
+#include "../../../../Utils/ServiceLocator.h"
+#include "../../../../Utils/Metrics.h"
+#include "../../../../Database/SessionKeyStore.h"
+#include "../../../../ECS/Components/Singletons/TimeSingleton.h"
+#include "../../../../Utils/AsyncLogger.h"
+#include <Networking/Packet.h>
 
 void Server::AuthHandlers::Setup(MessageHandler* messageHandler)
 {
     messageHandler->SetMessageHandler(Opcode::IMSG_HANDSHAKE, Server::AuthHandlers::HandshakeHandler);
-    messageHandler->SetMessageHandler(Opcode::IMSG_HANDSHAKE_RESPONSE, Server::AuthHandlers::HandshakeHandler);
+    messageHandler->SetMessageHandler(Opcode::IMSG_HANDSHAKE_RESPONSE, Server::AuthHandlers::HandshakeResponseHandler);
+    messageHandler->SetMessageHandler(Opcode::IMSG_VALIDATE_SESSION, Server::AuthHandlers::ValidateSessionHandler);
 }
-bool Server::AuthHandlers::HandshakeHandler(Packet*)
+bool Server::AuthHandlers::HandshakeHandler(Packet* packet)
 {
     // Handle initial handshake
-    NC_LOG_MESSAGE("Received Handshake");
+    NC_ASYNC_LOG_DEBUG("Received Handshake");
+
+    // The world server announces the realm it hosts, it shows up in the realm list from the next tick on
+    RealmInfo realmInfo;
+    if (!packet->payload->GetU32(realmInfo.id) || !packet->payload->GetString(realmInfo.name) || !packet->payload->GetString(realmInfo.address) ||
+        !packet->payload->GetU16(realmInfo.port) || !packet->payload->GetU8(realmInfo.type) || !packet->payload->GetU8(realmInfo.flags) ||
+        !packet->payload->GetU32(realmInfo.capacity))
+        return true;
+
+    ServiceLocator::GetRealmRegistry()->AddOrUpdate(packet->connection->GetIdentity(), realmInfo);
     return true;
 }
 bool Server::AuthHandlers::HandshakeResponseHandler(Packet*)
 {
     // Handle handshake response
-    NC_LOG_MESSAGE("Received Handshake Response");
+    NC_ASYNC_LOG_DEBUG("Received Handshake Response");
+    return true;
+}
+bool Server::AuthHandlers::ValidateSessionHandler(Packet* packet)
+{
+    // A world server asks whether the session key a client presented belongs to the account it claims,
+    // the store is read without locks so every internal shard can answer these in parallel
+    u32 accountId = 0;
+    SessionKey sessionKey;
+    if (!packet->payload->GetU32(accountId) || !packet->payload->GetBytes(sessionKey.data(), sessionKey.size()))
+        return true;
+
+    u64 nowNS = ServiceLocator::GetConnectionRegistry(packet->connection->GetIdentity())->ctx<TimeSingleton>().tickTimeNS;
+    bool isValid = ServiceLocator::GetSessionKeyStore()->Validate(accountId, sessionKey, nowNS);
+    Metrics::Increment(isValid ? MetricCounter::SESSIONS_VALIDATED : MetricCounter::SESSIONS_REJECTED);
+
+    // The world server may have several clients waiting on an answer, the account id tells it which one this is
+    PacketWriter writer;
+    writer.Put<u32>(accountId);
+    writer.Put<u8>(isValid ? 1 : 0);
+    PacketSender::Send(*packet->connection, Opcode::IMSG_VALIDATE_SESSION_RESPONSE, writer);
     return true;
 }
\ No newline at end of file
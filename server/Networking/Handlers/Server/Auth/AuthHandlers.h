@@ -10,5 +10,6 @@ namespace Server
         static void Setup(MessageHandler*);
         static bool HandshakeHandler(Packet*);
         static bool HandshakeResponseHandler(Packet*);
+        static bool ValidateSessionHandler(Packet*);
     };
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "RealmHandlers.h"
+#include "../../../MessageHandler.h"
+#include "../../../RealmRegistry.h"
+#include "../../../../Utils/ServiceLocator.h"
+#include <Networking/Packet.h>
+
+void Server::RealmHandlers::Setup(MessageHandler* messageHandler)
+{
+    messageHandler->SetMessageHandler(Opcode::IMSG_REALM_LOAD_REPORT, Server::RealmHandlers::LoadReportHandler);
+}
+bool Server::RealmHandlers::LoadReportHandler(Packet* packet)
+{
+    RealmLoad load;
+    if (!packet->payload->GetU32(load.playerCount) || !packet->payload->GetU32(load.tickTimeUS) || !packet->payload->GetU32(load.queueDepth))
+        return true;
+
+    // Reorders the realm's instances for the next client that joins, the realm list is only rebuilt when the population changed
+    ServiceLocator::GetRealmRegistry()->ReportLoad(packet->connection->GetIdentity(), load);
+    return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+class MessageHandler;
+struct Packet;
+namespace Server
+{
+    class RealmHandlers
+    {
+    public:
+        static void Setup(MessageHandler*);
+        static bool LoadReportHandler(Packet*);
+    };
+}
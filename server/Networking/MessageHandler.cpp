@@ -1,14 +1,52 @@
 #include "MessageHandler.h"
 #include "../ECS/Components/ConnectionComponent.h"
+#include "../ECS/Components/Singletons/TimeSingleton.h"
+#include "../Utils/AsyncLogger.h"
+#include <algorithm>
 
-MessageHandler::MessageHandler()
+struct alignas(64) MessageHandler::ThreadProfile
+{
+    struct OpcodeCounters
+    {
+        std::atomic<u64> calls = 0;
+        std::atomic<u64> deferrals = 0;
+        std::atomic<u64> totalNS = 0;
+        std::atomic<u64> maxNS = 0;
+    };
+
+    OpcodeCounters opcodes[Opcode::OPCODE_MAX_COUNT];
+    std::atomic<u64> rejectedOpcodes = 0;
+};
+
+namespace
+{
+    // Every MessageHandler gets its own slot in the thread local lookup, slots are never reused
+    constexpr u32 MAX_MESSAGE_HANDLERS = 8;
+    std::atomic<u32> nextMessageHandlerIndex(0);
+    thread_local void* threadProfiles[MAX_MESSAGE_HANDLERS] = {};
+
+    // Counters are only written by the thread owning them, a plain load and store avoids a locked add
+    void AddToOwnCounter(std::atomic<u64>& counter, u64 amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+}
+
+MessageHandler::MessageHandler() : _profilingEnabled(false)
 {
     for (i32 i = 0; i < Opcode::OPCODE_MAX_COUNT; i++)
     {
         handlers[i] = nullptr;
     }
+
+    // Handlers past the slots still dispatch, they just aren't profiled
+    _index = nextMessageHandlerIndex.fetch_add(1);
+    if (_index >= MAX_MESSAGE_HANDLERS)
+        NC_ASYNC_LOG_WARNING("MessageHandler %u is past the %u profiling slots, its dispatch won't be profiled", _index, MAX_MESSAGE_HANDLERS);
 }
 
+MessageHandler::~MessageHandler() = default;
+
 void MessageHandler::SetMessageHandler(Opcode opcode, MessageHandlerFn func)
 {
     handlers[opcode] = func;
@@ -16,5 +54,86 @@ void MessageHandler::SetMessageHandler(Opcode opcode, MessageHandlerFn func)
 
 bool MessageHandler::CallHandler(Packet* packet)
 {
-    return handlers[packet->header.opcode] ? handlers[packet->header.opcode](packet) : true;
-}
\ No newline at end of file
+    u32 opcode = packet->header.opcode;
+    if (opcode >= Opcode::OPCODE_MAX_COUNT)
+    {
+        // Consume it so the connection's queue moves on, retrying would not make the opcode any more valid
+        if (ThreadProfile* threadProfile = GetThreadProfile())
+            AddToOwnCounter(threadProfile->rejectedOpcodes, 1);
+        return true;
+    }
+
+    MessageHandlerFn handler = handlers[opcode];
+    if (!handler)
+        return true;
+
+    ThreadProfile* threadProfile = _profilingEnabled.load(std::memory_order_relaxed) ? GetThreadProfile() : nullptr;
+    if (!threadProfile)
+        return handler(packet);
+
+    u64 startNS = TimeSingleton::Now();
+    bool result = handler(packet);
+    u64 durationNS = TimeSingleton::Now() - startNS;
+
+    ThreadProfile::OpcodeCounters& counters = threadProfile->opcodes[opcode];
+    AddToOwnCounter(counters.calls, 1);
+    AddToOwnCounter(counters.totalNS, durationNS);
+    if (!result)
+        AddToOwnCounter(counters.deferrals, 1);
+    if (durationNS > counters.maxNS.load(std::memory_order_relaxed))
+        counters.maxNS.store(durationNS, std::memory_order_relaxed);
+
+    return result;
+}
+
+void MessageHandler::GetProfile(MessageHandlerProfile& profile)
+{
+    std::lock_guard<std::mutex> lock(_threadProfilesMutex);
+    for (std::unique_ptr<ThreadProfile>& threadProfile : _threadProfiles)
+    {
+        for (u32 i = 0; i < Opcode::OPCODE_MAX_COUNT; i++)
+        {
+            const ThreadProfile::OpcodeCounters& counters = threadProfile->opcodes[i];
+            OpcodeProfile& opcodeProfile = profile.opcodes[i];
+
+            opcodeProfile.calls += counters.calls.load(std::memory_order_relaxed);
+            opcodeProfile.deferrals += counters.deferrals.load(std::memory_order_relaxed);
+            opcodeProfile.totalNS += counters.totalNS.load(std::memory_order_relaxed);
+            opcodeProfile.maxNS = std::max(opcodeProfile.maxNS, counters.maxNS.load(std::memory_order_relaxed));
+        }
+
+        profile.rejectedOpcodes += threadProfile->rejectedOpcodes.load(std::memory_order_relaxed);
+    }
+}
+
+void MessageHandler::ResetProfile()
+{
+    std::lock_guard<std::mutex> lock(_threadProfilesMutex);
+    for (std::unique_ptr<ThreadProfile>& threadProfile : _threadProfiles)
+    {
+        for (ThreadProfile::OpcodeCounters& counters : threadProfile->opcodes)
+        {
+            counters.calls.store(0, std::memory_order_relaxed);
+            counters.deferrals.store(0, std::memory_order_relaxed);
+            counters.totalNS.store(0, std::memory_order_relaxed);
+            counters.maxNS.store(0, std::memory_order_relaxed);
+        }
+
+        threadProfile->rejectedOpcodes.store(0, std::memory_order_relaxed);
+    }
+}
+
+MessageHandler::ThreadProfile* MessageHandler::GetThreadProfile()
+{
+    if (_index >= MAX_MESSAGE_HANDLERS)
+        return nullptr;
+
+    if (void* threadProfile = threadProfiles[_index])
+        return static_cast<ThreadProfile*>(threadProfile);
+
+    std::lock_guard<std::mutex> lock(_threadProfilesMutex);
+    _threadProfiles.push_back(std::make_unique<ThreadProfile>());
+
+    threadProfiles[_index] = _threadProfiles.back().get();
+    return _threadProfiles.back().get();
+}
@@ -1,6 +1,25 @@
 #pragma once
+#include <NovusTypes.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "Opcodes.h"
 
+struct OpcodeProfile
+{
+    u64 calls = 0;
+    u64 deferrals = 0; // Calls where the handler returned false and the packet was kept for a retry
+    u64 totalNS = 0;
+    u64 maxNS = 0;
+};
+
+struct MessageHandlerProfile
+{
+    OpcodeProfile opcodes[Opcode::OPCODE_MAX_COUNT];
+    u64 rejectedOpcodes = 0; // Packets with an opcode outside of the handler table, counted even when profiling is off
+};
+
 struct Packet;
 class MessageHandler
 {
@@ -8,10 +27,26 @@ typedef bool (*MessageHandlerFn)(Packet*);
 
 public:
     MessageHandler();
+    ~MessageHandler();
 
     void SetMessageHandler(Opcode opcode, MessageHandlerFn func);
     bool CallHandler(Packet* packet);
 
+    // Instrumented dispatch, every thread calling handlers keeps its own counters which GetProfile sums up
+    void SetProfilingEnabled(bool enabled) { _profilingEnabled.store(enabled, std::memory_order_relaxed); }
+    bool IsProfilingEnabled() const { return _profilingEnabled.load(std::memory_order_relaxed); }
+    void GetProfile(MessageHandlerProfile& profile);
+    void ResetProfile();
+
+private:
+    struct ThreadProfile;
+    ThreadProfile* GetThreadProfile(); // Null for handlers created past MAX_MESSAGE_HANDLERS
+
 private:
     MessageHandlerFn handlers[Opcode::OPCODE_MAX_COUNT];
-};
\ No newline at end of file
+
+    u32 _index;
+    std::atomic<bool> _profilingEnabled;
+    std::mutex _threadProfilesMutex;
+    std::vector<std::unique_ptr<ThreadProfile>> _threadProfiles;
+};
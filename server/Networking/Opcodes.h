@@ -6,5 +6,13 @@ enum Opcode
     SMSG_HANDSHAKE,
     IMSG_HANDSHAKE,
     IMSG_HANDSHAKE_RESPONSE,
+    IMSG_VALIDATE_SESSION,
+    IMSG_VALIDATE_SESSION_RESPONSE,
+    IMSG_REALM_LOAD_REPORT,
+    CMSG_REALM_LIST,
+    SMSG_REALM_LIST,
+    CMSG_REALM_JOIN,
+    SMSG_REALM_JOIN,
+    CMSG_HANDSHAKE_PROOF,
     OPCODE_MAX_COUNT
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "PacketSender.h"
+#include "../Utils/AsyncLogger.h"
+#include <Networking/Connection.h>
+#include <Networking/Packet.h>
+#include <asio/ip/tcp.hpp>
+#include <asio/post.hpp>
+#include <asio/write.hpp>
+#include <algorithm>
+#include <array>
+#include <limits>
+
+void PacketWriter::PutString(const std::string& value)
+{
+    u8 length = static_cast<u8>(std::min<size_t>(value.size(), 255));
+    _data.push_back(length);
+    _data.insert(_data.end(), value.begin(), value.begin() + length);
+}
+
+void PacketSender::Send(Connection& connection, u16 opcode, PacketPayload payload)
+{
+    asio::ip::tcp::socket* socket = connection.GetSocket();
+    if (!socket)
+        return;
+
+    if (payload->size() > std::numeric_limits<u16>::max())
+    {
+        NC_ASYNC_LOG_WARNING("Dropped packet %u, its %u byte payload doesn't fit the packet header", opcode, static_cast<u32>(payload->size()));
+        return;
+    }
+
+    asio::post(socket->get_executor(), [socket, opcode, payload = std::move(payload)]()
+    {
+        PacketHeader header;
+        header.opcode = opcode;
+        header.size = static_cast<u16>(payload->size());
+
+        std::array<asio::const_buffer, 2> buffers = { asio::buffer(&header, sizeof(header)), asio::buffer(*payload) };
+
+        asio::error_code errorCode;
+        socket->non_blocking(true, errorCode);
+        if (!errorCode)
+            asio::write(*socket, buffers, errorCode);
+
+        if (errorCode)
+        {
+            socket->shutdown(asio::ip::tcp::socket::shutdown_both, errorCode);
+            socket->close(errorCode);
+        }
+    });
+}
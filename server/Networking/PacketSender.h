@@ -0,0 +1,67 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Connection;
+
+// Payload of a packet the engine sends, shared so one payload can go to many connections without copying it
+typedef std::shared_ptr<const std::vector<u8>> PacketPayload;
+
+// Builds a payload, little endian with u8 length prefixed strings
+class PacketWriter
+{
+public:
+    template <typename T>
+    void Put(T value)
+    {
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            _data.push_back(static_cast<u8>(value >> (i * 8)));
+        }
+    }
+
+    void PutBytes(const u8* data, size_t size) { _data.insert(_data.end(), data, data + size); }
+    void PutString(const std::string& value);
+
+    void Reserve(size_t size) { _data.reserve(size); }
+    PacketPayload Finish() { return std::make_shared<const std::vector<u8>>(std::move(_data)); }
+
+private:
+    std::vector<u8> _data;
+};
+
+// Writes packets to connections from the engine side, framed with the PacketHeader the network library reads.
+// The network library runs its io context on a single thread, so the packets one thread sends to a connection arrive in order
+class PacketSender
+{
+public:
+    // Thread safe, the write runs on the socket's io context like ConnectionCloser's close does.
+    // A connection that doesn't read fast enough to take the packet right away is closed instead of stalling the io context
+    static void Send(Connection& connection, u16 opcode, PacketPayload payload);
+    static void Send(Connection& connection, u16 opcode, PacketWriter& writer) { Send(connection, opcode, writer.Finish()); }
+};
@@ -0,0 +1,201 @@
+#include "RateLimiter.h"
+#include <Networking/Connection.h>
+#include <asio/ip/tcp.hpp>
+#include <algorithm>
+
+namespace
+{
+    u64 HashBytes(const u8* data, size_t size)
+    {
+        // FNV-1a followed by a finalizer so neighbouring addresses spread over the table
+        u64 hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= data[i];
+            hash *= 0x100000001b3ull;
+        }
+
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+}
+
+TokenBucketTable::TokenBucketTable(u32 capacity, const TokenBucketConfig& config) : _config(config)
+{
+    u32 size = 1;
+    while (size < std::max(capacity, MAX_PROBE_LENGTH))
+    {
+        size <<= 1;
+    }
+
+    _buckets.resize(size);
+    _mask = size - 1;
+}
+
+RateLimitResult TokenBucketTable::Consume(u64 key, u64 nowNS)
+{
+    Bucket* bucket = FindOrClaim(key, nowNS);
+
+    // Every slot we could use is banned, let it through rather than punish a key we can't track
+    if (!bucket)
+        return RateLimitResult::ALLOWED;
+
+    if (bucket->bannedUntilNS > nowNS)
+        return RateLimitResult::BANNED;
+
+    f32 elapsedSeconds = static_cast<f32>(nowNS - bucket->lastRefillNS) * 1e-9f;
+    bucket->tokens = std::min(_config.burst, bucket->tokens + elapsedSeconds * _config.refillPerSecond);
+    bucket->lastRefillNS = nowNS;
+
+    if (bucket->tokens >= 1.0f)
+    {
+        bucket->tokens -= 1.0f;
+        bucket->strikes = 0;
+        return RateLimitResult::ALLOWED;
+    }
+
+    bucket->strikes++;
+    if (_config.strikesBeforeBan && bucket->strikes >= _config.strikesBeforeBan)
+    {
+        bucket->bannedUntilNS = nowNS + _config.banDurationNS;
+        bucket->strikes = 0;
+        return RateLimitResult::BANNED;
+    }
+
+    return RateLimitResult::LIMITED;
+}
+
+void TokenBucketTable::Ban(u64 key, u64 nowNS, u64 durationNS)
+{
+    if (Bucket* bucket = FindOrClaim(key, nowNS))
+        bucket->bannedUntilNS = std::max(bucket->bannedUntilNS, nowNS + durationNS);
+}
+
+bool TokenBucketTable::IsBanned(u64 key, u64 nowNS) const
+{
+    const Bucket* bucket = Find(key);
+    return bucket && bucket->bannedUntilNS > nowNS;
+}
+
+const TokenBucketTable::Bucket* TokenBucketTable::Find(u64 key) const
+{
+    key = key ? key : 1;
+
+    // Same probe window as FindOrClaim
+    for (u32 i = 0; i < MAX_PROBE_LENGTH; i++)
+    {
+        const Bucket& bucket = _buckets[(key + i) & _mask];
+        if (bucket.key == key)
+            return &bucket;
+
+        if (bucket.key == 0)
+            break;
+    }
+
+    return nullptr;
+}
+
+TokenBucketTable::Bucket* TokenBucketTable::FindOrClaim(u64 key, u64 nowNS)
+{
+    key = key ? key : 1;
+
+    // Slots are recycled but never emptied, so the first empty slot ends the search
+    Bucket* victim = nullptr;
+    for (u32 i = 0; i < MAX_PROBE_LENGTH; i++)
+    {
+        Bucket& bucket = _buckets[(key + i) & _mask];
+        if (bucket.key == key)
+            return &bucket;
+
+        if (bucket.key == 0)
+        {
+            victim = &bucket;
+            break;
+        }
+
+        if (bucket.bannedUntilNS <= nowNS && (!victim || bucket.lastRefillNS < victim->lastRefillNS))
+            victim = &bucket;
+    }
+
+    if (!victim)
+        return nullptr;
+
+    victim->key = key;
+    victim->lastRefillNS = nowNS;
+    victim->bannedUntilNS = 0;
+    victim->tokens = _config.burst;
+    victim->strikes = 0;
+    return victim;
+}
+
+RateLimiter::RateLimiter(const RateLimiterConfig& config) : _addressBuckets(config.addressTableSize, config.address)
+{
+}
+
+RateLimitResult RateLimiter::CheckAddress(u64 addressKey, u64 nowNS)
+{
+    return _addressBuckets.Consume(addressKey, nowNS);
+}
+
+u64 RateLimiter::GetAddressKey(Connection& connection)
+{
+    asio::ip::tcp::socket* socket = connection.GetSocket();
+    asio::error_code errorCode;
+    asio::ip::tcp::endpoint endpoint = socket ? socket->remote_endpoint(errorCode) : asio::ip::tcp::endpoint();
+    if (!socket || errorCode)
+    {
+        // Keyed by the connection instead, letting it through unlimited would make a socket without an address a way around the limits
+        const Connection* connectionAddress = &connection;
+        return HashBytes(reinterpret_cast<const u8*>(&connectionAddress), sizeof(connectionAddress));
+    }
+
+    // Only the address, every connection from the same host shares its buckets
+    asio::ip::address address = endpoint.address();
+    if (address.is_v4())
+    {
+        asio::ip::address_v4::bytes_type bytes = address.to_v4().to_bytes();
+        return HashBytes(bytes.data(), bytes.size());
+    }
+
+    asio::ip::address_v6::bytes_type bytes = address.to_v6().to_bytes();
+    return HashBytes(bytes.data(), bytes.size());
+}
+
+AccountRateLimiter::AccountRateLimiter(const RateLimiterConfig& config)
+    : _accountBuckets(config.accountTableSize, config.account), _accountBanDurationNS(config.account.banDurationNS)
+{
+}
+
+bool AccountRateLimiter::IsAccountBanned(const std::string& accountName, u64 nowNS)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _accountBuckets.IsBanned(GetAccountKey(accountName), nowNS);
+}
+
+RateLimitResult AccountRateLimiter::RecordFailedLogin(const std::string& accountName, u64 nowNS)
+{
+    u64 accountKey = GetAccountKey(accountName);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    RateLimitResult result = _accountBuckets.Consume(accountKey, nowNS);
+    if (result != RateLimitResult::LIMITED)
+        return result;
+
+    _accountBuckets.Ban(accountKey, nowNS, _accountBanDurationNS);
+    return RateLimitResult::BANNED;
+}
+
+void AccountRateLimiter::BanAccount(const std::string& accountName, u64 nowNS, u64 durationNS)
+{
+    u64 accountKey = GetAccountKey(accountName);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _accountBuckets.Ban(accountKey, nowNS, durationNS);
+}
+
+u64 AccountRateLimiter::GetAccountKey(const std::string& accountName)
+{
+    return HashBytes(reinterpret_cast<const u8*>(accountName.data()), accountName.size());
+}
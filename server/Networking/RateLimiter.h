@@ -0,0 +1,127 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Connection;
+
+struct TokenBucketConfig
+{
+    f32 burst; // Tokens a full bucket holds
+    f32 refillPerSecond;
+    u32 strikesBeforeBan; // Rejections in a row before the key is banned, 0 never bans
+    u64 banDurationNS;
+};
+
+enum class RateLimitResult : u8
+{
+    ALLOWED,
+    LIMITED,
+    BANNED
+};
+
+// Fixed size open addressing table of token buckets keyed by a 64 bit hash. Buckets refill lazily when they are touched,
+// so nothing has to sweep the table and Consume never allocates. When the probe window is full the stalest bucket
+// that isn't banned is recycled. Not thread safe.
+class TokenBucketTable
+{
+public:
+    TokenBucketTable(u32 capacity, const TokenBucketConfig& config);
+
+    RateLimitResult Consume(u64 key, u64 nowNS);
+    void Ban(u64 key, u64 nowNS, u64 durationNS);
+    bool IsBanned(u64 key, u64 nowNS) const; // Never claims a bucket, probing unknown keys can't push out a ban
+
+    static constexpr u32 MAX_PROBE_LENGTH = 16;
+
+private:
+    struct Bucket
+    {
+        u64 key = 0; // 0 marks an empty slot
+        u64 lastRefillNS = 0;
+        u64 bannedUntilNS = 0;
+        f32 tokens = 0;
+        u32 strikes = 0;
+    };
+
+    const Bucket* Find(u64 key) const;
+    Bucket* FindOrClaim(u64 key, u64 nowNS);
+
+private:
+    TokenBucketConfig _config;
+    std::vector<Bucket> _buckets;
+    u32 _mask;
+};
+
+struct RateLimiterConfig
+{
+    u32 addressTableSize = 65536;
+    TokenBucketConfig address = { 64.0f, 32.0f, 256, 60ull * 1000000000ull };
+
+    // Only failed logins take a token, the account is banned for banDurationNS as soon as one finds the bucket empty
+    u32 accountTableSize = 16384;
+    TokenBucketConfig account = { 5.0f, 0.1f, 0, 300ull * 1000000000ull };
+};
+
+// Per source address packet limits, every engine shard has its own and uses it from its thread only.
+// The connections of one address all land on the same shard, so the limits are exact
+class RateLimiter
+{
+public:
+    RateLimiter(const RateLimiterConfig& config = RateLimiterConfig());
+
+    RateLimitResult CheckAddress(u64 addressKey, u64 nowNS);
+    void BanAddress(u64 addressKey, u64 nowNS, u64 durationNS) { _addressBuckets.Ban(addressKey, nowNS, durationNS); }
+
+    // A connection whose socket has no remote address, because it isn't connected or already disconnected, gets a bucket of its own
+    static u64 GetAddressKey(Connection& connection);
+
+private:
+    TokenBucketTable _addressBuckets;
+};
+
+// Per account login attempt limits, shared by every engine shard since the connections logging in to one account
+// can come from any address and so from any shard. Thread safe
+class AccountRateLimiter
+{
+public:
+    AccountRateLimiter(const RateLimiterConfig& config = RateLimiterConfig());
+
+    // Checked before a proof is verified, doesn't cost the account anything
+    bool IsAccountBanned(const std::string& accountName, u64 nowNS);
+    // Called for every proof that failed to verify, returns BANNED once the account ran out of attempts
+    RateLimitResult RecordFailedLogin(const std::string& accountName, u64 nowNS);
+
+    void BanAccount(const std::string& accountName, u64 nowNS, u64 durationNS);
+
+    static u64 GetAccountKey(const std::string& accountName);
+
+private:
+    std::mutex _mutex;
+    TokenBucketTable _accountBuckets;
+    u64 _accountBanDurationNS;
+};
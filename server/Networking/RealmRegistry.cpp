@@ -0,0 +1,302 @@
+#include "RealmRegistry.h"
+#include "ConnectionIdentity.h"
+#include "ConnectionHandleTable.h"
+#include "../ECS/Components/ConnectionComponent.h"
+#include <algorithm>
+#include <tracy/Tracy.hpp>
+
+RealmRegistry::RealmRegistry() : _isDirty(true), _queuedCount(0), _version(0)
+{
+    Publish();
+}
+
+void RealmRegistry::AddOrUpdate(u64 instance, const RealmInfo& realmInfo)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t instanceIndex;
+    if (Realm* realm = FindInstance(instance, instanceIndex))
+    {
+        if (realm->id == realmInfo.id)
+        {
+            realm->instances[instanceIndex].info = realmInfo;
+            UpdateScore(*realm, instanceIndex);
+            _isDirty = true;
+            return;
+        }
+
+        // The world server switched realms, drop the old instance and add it to the new realm
+        realm->instances.erase(realm->instances.begin() + instanceIndex);
+    }
+
+    Realm* realm = FindRealm(realmInfo.id);
+    if (!realm)
+    {
+        _realms.push_back({ realmInfo.id, {}, {} });
+        realm = &_realms.back();
+    }
+
+    RealmInstance newInstance;
+    newInstance.identity = instance;
+    newInstance.info = realmInfo;
+    newInstance.load.playerCount = realmInfo.population;
+    newInstance.pendingPlayers = 0;
+    newInstance.score = 0.0f;
+    realm->instances.push_back(newInstance);
+    UpdateScore(*realm, realm->instances.size() - 1);
+
+    _isDirty = true;
+}
+
+void RealmRegistry::ReportLoad(u64 instance, const RealmLoad& load)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t instanceIndex;
+    Realm* realm = FindInstance(instance, instanceIndex);
+    if (!realm)
+        return;
+
+    // The reported player count includes the clients we assigned since the last report
+    RealmInstance& realmInstance = realm->instances[instanceIndex];
+    realmInstance.load = load;
+    realmInstance.pendingPlayers = 0;
+
+    // Only the population is part of the realm list, other load changes don't need a rebuild
+    if (realmInstance.info.population != load.playerCount)
+    {
+        realmInstance.info.population = load.playerCount;
+        _isDirty = true;
+    }
+
+    UpdateScore(*realm, instanceIndex);
+}
+
+void RealmRegistry::Remove(u64 instance)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t instanceIndex;
+    Realm* realm = FindInstance(instance, instanceIndex);
+    if (!realm)
+        return;
+
+    realm->instances.erase(realm->instances.begin() + instanceIndex);
+
+    // Keep a realm with queued clients around, another instance may come up for them
+    if (realm->instances.empty() && realm->queue.empty())
+    {
+        _realms.erase(_realms.begin() + (realm - _realms.data()));
+    }
+
+    _isDirty = true;
+}
+
+RealmJoinResult RealmRegistry::JoinRealm(u64 identity, u32 realmId, u32 joinSerial, RealmAssignment& assignment)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Realm* realm = FindRealm(realmId);
+    if (!realm || realm->instances.empty())
+        return RealmJoinResult::UNKNOWN_REALM;
+
+    // Clients already waiting go first
+    if (realm->queue.empty() && HasRoom(realm->instances.front()))
+    {
+        Assign(*realm, identity, assignment);
+        return RealmJoinResult::ASSIGNED;
+    }
+
+    realm->queue.push_back({ identity, joinSerial });
+    _queuedCount.fetch_add(1, std::memory_order_relaxed);
+    return RealmJoinResult::QUEUED;
+}
+
+void RealmRegistry::AssignQueued(u32 shardIndex, entt::registry& registry, std::vector<RealmAssignment>& assignments)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (Realm& realm : _realms)
+    {
+        if (realm.queue.empty())
+            continue;
+
+        // One pass over the queue, the clients kept are moved up over the ones that were dropped or assigned
+        size_t keptCount = 0;
+        bool isBlocked = false; // A client that stays queued is ahead of everyone behind it
+        for (size_t i = 0; i < realm.queue.size(); i++)
+        {
+            const QueuedClient queuedClient = realm.queue[i];
+            bool isOwned = ConnectionIdentity::GetShardIndex(queuedClient.identity) == shardIndex;
+
+            if (isOwned && !IsStillQueued(registry, realm, queuedClient))
+                continue;
+
+            if (isOwned && !isBlocked && !realm.instances.empty() && HasRoom(realm.instances.front()))
+            {
+                RealmAssignment assignment;
+                Assign(realm, queuedClient.identity, assignment);
+                assignments.push_back(assignment);
+                continue;
+            }
+
+            isBlocked = true;
+            realm.queue[keptCount++] = queuedClient;
+        }
+
+        _queuedCount.fetch_sub(static_cast<u32>(realm.queue.size() - keptCount), std::memory_order_relaxed);
+        realm.queue.resize(keptCount);
+    }
+}
+
+void RealmRegistry::WriteJoinResult(PacketWriter& writer, RealmJoinResult result, u32 realmId, const RealmAssignment& assignment)
+{
+    writer.Put<u8>(static_cast<u8>(result));
+    writer.Put<u32>(realmId);
+
+    if (result == RealmJoinResult::ASSIGNED)
+    {
+        writer.PutString(assignment.address);
+        writer.Put<u16>(assignment.port);
+    }
+}
+
+void RealmRegistry::Publish()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_isDirty)
+        return;
+
+    ZoneScopedNC("RealmRegistry::Publish", tracy::Color::Yellow2)
+
+    u32 version = _version.load(std::memory_order_relaxed) + 1;
+
+    // Realms keep the order they connected in, ids decide the order clients show them in
+    std::vector<const Realm*> sortedRealms;
+    sortedRealms.reserve(_realms.size());
+    for (const Realm& realm : _realms)
+    {
+        if (!realm.instances.empty())
+            sortedRealms.push_back(&realm);
+    }
+    std::sort(sortedRealms.begin(), sortedRealms.end(), [](const Realm* a, const Realm* b) { return a->id < b->id; });
+
+    PacketWriter realmList;
+    realmList.Reserve(6 + sortedRealms.size() * 64);
+    realmList.Put<u32>(version);
+    realmList.Put<u16>(static_cast<u16>(sortedRealms.size()));
+
+    for (const Realm* realm : sortedRealms)
+    {
+        // Instances of a realm show up as one entry, clients are sent to a specific instance when they join
+        u32 population = 0;
+        u32 capacity = 0;
+        for (const RealmInstance& instance : realm->instances)
+        {
+            population += instance.info.population;
+            capacity += instance.info.capacity;
+        }
+
+        const RealmInfo& info = realm->instances.front().info;
+        realmList.Put<u32>(info.id);
+        realmList.Put<u8>(info.type);
+        realmList.Put<u8>(info.flags);
+        realmList.Put<u32>(population);
+        realmList.Put<u32>(capacity);
+        realmList.PutString(info.name);
+        realmList.PutString(info.address);
+        realmList.Put<u16>(info.port);
+    }
+
+    // Readers still holding the previous blob keep it alive until they are done with it
+    std::atomic_store(&_realmList, realmList.Finish());
+    _version.store(version, std::memory_order_release);
+    _isDirty = false;
+}
+
+RealmRegistry::Realm* RealmRegistry::FindRealm(u32 realmId)
+{
+    for (Realm& realm : _realms)
+    {
+        if (realm.id == realmId)
+            return &realm;
+    }
+
+    return nullptr;
+}
+
+RealmRegistry::Realm* RealmRegistry::FindInstance(u64 instance, size_t& instanceIndex)
+{
+    for (Realm& realm : _realms)
+    {
+        for (size_t i = 0; i < realm.instances.size(); i++)
+        {
+            if (realm.instances[i].identity == instance)
+            {
+                instanceIndex = i;
+                return &realm;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+void RealmRegistry::UpdateScore(Realm& realm, size_t instanceIndex)
+{
+    RealmInstance& instance = realm.instances[instanceIndex];
+
+    // Occupancy, plus how far the instance is over its tick budget, plus its backlog relative to its size
+    f32 capacity = static_cast<f32>(std::max(instance.info.capacity, 1u));
+    f32 occupancy = static_cast<f32>(instance.load.playerCount + instance.pendingPlayers) / capacity;
+    f32 tickPressure = std::max(0.0f, static_cast<f32>(instance.load.tickTimeUS) / TARGET_TICK_TIME_US - 1.0f);
+    f32 backlog = static_cast<f32>(instance.load.queueDepth) / capacity;
+    instance.score = occupancy + tickPressure + backlog;
+
+    // Full instances sort last so the front is always the best candidate, one insertion step restores the order
+    auto isBetter = [](const RealmInstance& a, const RealmInstance& b)
+    {
+        bool aHasRoom = HasRoom(a);
+        if (aHasRoom != HasRoom(b))
+            return aHasRoom;
+
+        return a.score < b.score;
+    };
+
+    size_t i = instanceIndex;
+    while (i > 0 && isBetter(realm.instances[i], realm.instances[i - 1]))
+    {
+        std::swap(realm.instances[i], realm.instances[i - 1]);
+        i--;
+    }
+    while (i + 1 < realm.instances.size() && isBetter(realm.instances[i + 1], realm.instances[i]))
+    {
+        std::swap(realm.instances[i], realm.instances[i + 1]);
+        i++;
+    }
+}
+
+bool RealmRegistry::IsStillQueued(entt::registry& registry, const Realm& realm, const QueuedClient& queuedClient)
+{
+    // Gone, or joined a realm again after this entry was queued, even if it was this realm again
+    entt::entity entity = registry.ctx<ConnectionHandleTable>().Resolve(queuedClient.identity, ConnectionKind::CLIENT);
+    if (entity == entt::null)
+        return false;
+
+    const ConnectionComponent& connectionComponent = registry.get<ConnectionComponent>(entity);
+    return connectionComponent.queuedRealmId == realm.id && connectionComponent.realmJoinSerial == queuedClient.joinSerial;
+}
+
+void RealmRegistry::Assign(Realm& realm, u64 identity, RealmAssignment& assignment)
+{
+    // Count the client right away so a burst of logins spreads over the instances instead of waiting for the next load report
+    realm.instances.front().pendingPlayers++;
+
+    assignment.identity = identity;
+    assignment.instance = realm.instances.front().identity;
+    assignment.realmId = realm.id;
+    assignment.address = realm.instances.front().info.address;
+    assignment.port = realm.instances.front().info.port;
+
+    UpdateScore(realm, 0);
+}
@@ -0,0 +1,150 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <entt.hpp>
+#include "PacketSender.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct RealmInfo
+{
+    u32 id = 0;
+    std::string name;
+    std::string address;
+    u16 port = 0;
+    u8 type = 0;
+    u8 flags = 0;
+    u32 population = 0;
+    u32 capacity = 0;
+};
+
+// Reported by a world server instance through IMSG_REALM_LOAD_REPORT
+struct RealmLoad
+{
+    u32 playerCount = 0;
+    u32 tickTimeUS = 0;
+    u32 queueDepth = 0; // Packets waiting to be handled on the world server
+};
+
+enum class RealmJoinResult : u8
+{
+    ASSIGNED,
+    QUEUED, // Every instance is full, the client is assigned by AssignQueued once one has room
+    UNKNOWN_REALM
+};
+
+// Clients and world servers are known by their connection identity, they may belong to any engine shard
+struct RealmAssignment
+{
+    u64 identity = 0; // Client connection
+    u64 instance = 0; // Internal connection of the world server
+    u32 realmId = 0;
+    std::string address; // Where the client connects to the instance
+    u16 port = 0;
+};
+
+// Serialized realm list, shared as is by every client that asks for it
+typedef PacketPayload RealmListBlob;
+
+// Realms announced by the world servers over their internal connection. Several world servers may host instances of the same realm,
+// logging in clients are sent to the least loaded instance that has room and wait in the realm's queue while every instance is full.
+//
+// The list clients receive is serialized once per change instead of once per request: changes only mark the registry dirty,
+// Publish rebuilds the blob at most once per tick and GetRealmList hands out a reference to it.
+// Blob layout, little endian: u32 version, u16 realm count, then per realm
+// u32 id, u8 type, u8 flags, u32 population, u32 capacity, u8 name length, name, u8 address length, address, u16 port
+class RealmRegistry
+{
+public:
+    RealmRegistry();
+
+    // Thread safe, called by the internal handlers
+    void AddOrUpdate(u64 instance, const RealmInfo& realmInfo);
+    void ReportLoad(u64 instance, const RealmLoad& load);
+    void Remove(u64 instance);
+
+    // Thread safe, called by the client handlers. joinSerial is the client's ConnectionComponent::realmJoinSerial after this join
+    RealmJoinResult JoinRealm(u64 identity, u32 realmId, u32 joinSerial, RealmAssignment& assignment);
+
+    // Called by every engine shard once per tick with its own registry, hands the shard's queued clients to instances that have room again.
+    // A realm's queue stays first come first served across shards, a shard stops assigning at the first client another shard owns.
+    // Entries of the shard's clients that disconnected or joined again meanwhile are dropped wherever they are in the queue
+    void AssignQueued(u32 shardIndex, entt::registry& registry, std::vector<RealmAssignment>& assignments);
+    void Publish();
+
+    // SMSG_REALM_JOIN, little endian: u8 RealmJoinResult, u32 realm id, for ASSIGNED followed by u8 address length, address, u16 port
+    static void WriteJoinResult(PacketWriter& writer, RealmJoinResult result, u32 realmId, const RealmAssignment& assignment);
+
+    // Thread safe, never copies the list
+    RealmListBlob GetRealmList() const { return std::atomic_load(&_realmList); }
+    u32 GetVersion() const { return _version.load(std::memory_order_acquire); }
+    u32 GetQueuedCount() const { return _queuedCount.load(std::memory_order_relaxed); }
+
+    // Tick time a world server is expected to stay under, instances above it are treated as more loaded than their player count says
+    static constexpr u32 TARGET_TICK_TIME_US = 50000;
+
+private:
+    struct RealmInstance
+    {
+        u64 identity;
+        RealmInfo info;
+        RealmLoad load;
+        u32 pendingPlayers; // Assigned since the instance's last load report
+        f32 score; // Lower is less loaded
+    };
+
+    struct QueuedClient
+    {
+        u64 identity;
+        u32 joinSerial;
+    };
+
+    struct Realm
+    {
+        u32 id;
+        std::vector<RealmInstance> instances; // Kept sorted by score, realms rarely have more than a handful
+        std::deque<QueuedClient> queue;
+    };
+
+    Realm* FindRealm(u32 realmId);
+    Realm* FindInstance(u64 instance, size_t& instanceIndex);
+    static void UpdateScore(Realm& realm, size_t instanceIndex);
+    static bool HasRoom(const RealmInstance& instance) { return instance.load.playerCount + instance.pendingPlayers < instance.info.capacity; }
+    static void Assign(Realm& realm, u64 identity, RealmAssignment& assignment);
+    static bool IsStillQueued(entt::registry& registry, const Realm& realm, const QueuedClient& queuedClient);
+
+private:
+    std::mutex _mutex;
+    std::vector<Realm> _realms;
+    bool _isDirty;
+    std::atomic<u32> _queuedCount;
+
+    RealmListBlob _realmList;
+    std::atomic<u32> _version;
+};
@@ -0,0 +1,159 @@
+#include "AsyncLogger.h"
+#include "Metrics.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    struct LoggerState
+    {
+        LoggerState()
+        {
+            for (u32 i = 0; i < AsyncLogger::RING_SIZE; i++)
+            {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        LogSlot slots[AsyncLogger::RING_SIZE];
+        alignas(64) std::atomic<u64> enqueuePosition{ 0 };
+        alignas(64) std::atomic<u64> droppedCount{ 0 };
+        u64 dequeuePosition = 0; // Only touched by the flusher
+
+        std::mutex flushMutex;
+        std::condition_variable flushCondition;
+        std::thread flushThread;
+        bool stopFlushing = false;
+    };
+
+    // Never destroyed, the detached engine threads may still log while statics are torn down
+    LoggerState& GetState()
+    {
+        static LoggerState* state = new LoggerState();
+        return *state;
+    }
+
+    const char* levelNames[] =
+    {
+        "Debug",
+        "Message",
+        "Warning",
+        "Critical"
+    };
+
+    // Returns false once the ring is empty
+    bool FlushBatch(LoggerState& state, u64& reportedDroppedCount)
+    {
+        constexpr u32 FLUSH_BATCH_SIZE = 256;
+        char line[512];
+        u32 written = 0;
+
+        for (; written < FLUSH_BATCH_SIZE; written++)
+        {
+            LogSlot& slot = state.slots[state.dequeuePosition & (AsyncLogger::RING_SIZE - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != state.dequeuePosition + 1)
+                break;
+
+            const LogEntry& entry = slot.entry;
+            i32 prefixLength = snprintf(line, sizeof(line), "[%.6f] [%s] ", entry.timeNS / 1000000000.0, levelNames[static_cast<u32>(entry.level)]);
+            entry.formatFunction(line + prefixLength, sizeof(line) - prefixLength, entry.format, entry.args);
+            // One call per line, stdio keeps it in one piece next to the NC_LOG_* output of other threads
+            std::fprintf(stdout, "%s\n", line);
+
+            slot.sequence.store(state.dequeuePosition + AsyncLogger::RING_SIZE, std::memory_order_release);
+            state.dequeuePosition++;
+        }
+
+        u64 droppedCount = state.droppedCount.load(std::memory_order_relaxed);
+        if (droppedCount != reportedDroppedCount)
+        {
+            std::fprintf(stdout, "[Warning] Dropped %llu log messages, the log ring was full\n", static_cast<unsigned long long>(droppedCount - reportedDroppedCount));
+            reportedDroppedCount = droppedCount;
+        }
+
+        if (written > 0)
+            std::fflush(stdout);
+
+        return written == FLUSH_BATCH_SIZE;
+    }
+}
+
+LogSlot* AsyncLogger::BeginEntry()
+{
+    LoggerState& state = GetState();
+
+    u64 position = state.enqueuePosition.load(std::memory_order_relaxed);
+    while (true)
+    {
+        LogSlot& slot = state.slots[position & (RING_SIZE - 1)];
+        i64 difference = static_cast<i64>(slot.sequence.load(std::memory_order_acquire) - position);
+
+        if (difference == 0)
+        {
+            if (state.enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                slot.position = position;
+                return &slot;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The flusher hasn't caught up, losing a line beats stalling the caller
+            state.droppedCount.fetch_add(1, std::memory_order_relaxed);
+            Metrics::Increment(MetricCounter::LOG_MESSAGES_DROPPED);
+            return nullptr;
+        }
+        else
+        {
+            position = state.enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncLogger::Start(std::chrono::milliseconds flushInterval)
+{
+    LoggerState& state = GetState();
+    if (state.flushThread.joinable())
+        return;
+
+    state.stopFlushing = false;
+    state.flushThread = std::thread([flushInterval]()
+    {
+        LoggerState& state = GetState();
+        u64 reportedDroppedCount = state.droppedCount.load(std::memory_order_relaxed);
+
+        // Producers don't signal us, that would cost them a syscall, so the flusher polls the ring
+        std::unique_lock<std::mutex> lock(state.flushMutex);
+        while (!state.stopFlushing)
+        {
+            lock.unlock();
+            while (FlushBatch(state, reportedDroppedCount)) { }
+            lock.lock();
+
+            state.flushCondition.wait_for(lock, flushInterval, [&state]() { return state.stopFlushing; });
+        }
+        lock.unlock();
+
+        while (FlushBatch(state, reportedDroppedCount)) { }
+    });
+}
+
+void AsyncLogger::Stop()
+{
+    LoggerState& state = GetState();
+    if (!state.flushThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(state.flushMutex);
+        state.stopFlushing = true;
+    }
+    state.flushCondition.notify_all();
+    state.flushThread.join();
+}
+
+u64 AsyncLogger::GetDroppedCount()
+{
+    return GetState().droppedCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,137 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include "../ECS/Components/Singletons/TimeSingleton.h"
+
+enum class LogLevel : u8
+{
+    DEBUG,
+    MESSAGE,
+    WARNING,
+    CRITICAL
+};
+
+// Levels below this are compiled out, define it in the build to change it
+#ifndef NC_ASYNC_LOG_LEVEL
+#ifdef NDEBUG
+#define NC_ASYNC_LOG_LEVEL 1 // LogLevel::MESSAGE
+#else
+#define NC_ASYNC_LOG_LEVEL 0 // LogLevel::DEBUG
+#endif
+#endif
+
+#define NC_ASYNC_LOG_DEBUG(format, ...) AsyncLogger::Log<LogLevel::DEBUG>(format, ##__VA_ARGS__)
+#define NC_ASYNC_LOG_MESSAGE(format, ...) AsyncLogger::Log<LogLevel::MESSAGE>(format, ##__VA_ARGS__)
+#define NC_ASYNC_LOG_WARNING(format, ...) AsyncLogger::Log<LogLevel::WARNING>(format, ##__VA_ARGS__)
+#define NC_ASYNC_LOG_CRITICAL(format, ...) AsyncLogger::Log<LogLevel::CRITICAL>(format, ##__VA_ARGS__)
+
+// A log call only copies its format pointer, its arguments and a formatting function into a slot of a preallocated ring,
+// formatting and writing to stdout happens on the flusher thread. The format has to be a string literal and the arguments numbers,
+// text that isn't known at compile time can't be logged through here.
+struct LogEntry
+{
+    static constexpr size_t ARG_STORAGE_SIZE = 64;
+    typedef void (*FormatFunction)(char* buffer, size_t bufferSize, const char* format, const u8* args);
+
+    const char* format;
+    FormatFunction formatFunction;
+    u64 timeNS;
+    LogLevel level;
+    alignas(8) u8 args[ARG_STORAGE_SIZE];
+};
+
+struct alignas(64) LogSlot
+{
+    std::atomic<u64> sequence;
+    u64 position;
+    LogEntry entry;
+};
+
+// Multi producer, single consumer ring of RING_SIZE slots, producers claim a slot with a single CAS and never wait.
+// While the ring is full new entries are dropped and counted, the flusher reports how many it lost.
+class AsyncLogger
+{
+public:
+    static constexpr u32 RING_SIZE = 8192; // Has to be a power of two
+
+    static constexpr bool IsEnabled(LogLevel level) { return level >= static_cast<LogLevel>(NC_ASYNC_LOG_LEVEL); }
+
+    template <LogLevel Level, typename... Args>
+    static void Log(const char* format, Args... args)
+    {
+        if constexpr (IsEnabled(Level))
+        {
+            typedef std::tuple<Args...> ArgTuple;
+            static_assert(((std::is_arithmetic<Args>::value || std::is_enum<Args>::value) && ...), "Only numbers can be logged as arguments");
+            static_assert(sizeof(ArgTuple) <= LogEntry::ARG_STORAGE_SIZE, "Too many arguments for a log entry");
+
+            LogSlot* slot = BeginEntry();
+            if (!slot)
+                return;
+
+            LogEntry& entry = slot->entry;
+            entry.format = format;
+            entry.formatFunction = &FormatEntry<Args...>;
+            entry.timeNS = TimeSingleton::Now();
+            entry.level = Level;
+            new (entry.args) ArgTuple(args...);
+
+            CommitEntry(slot);
+        }
+    }
+
+    // Starts the flusher thread, entries logged before are kept until the ring is full
+    static void Start(std::chrono::milliseconds flushInterval = std::chrono::milliseconds(10));
+
+    // Writes out everything logged so far and stops the flusher thread
+    static void Stop();
+
+    static u64 GetDroppedCount();
+
+private:
+    static LogSlot* BeginEntry();
+    static void CommitEntry(LogSlot* slot) { slot->sequence.store(slot->position + 1, std::memory_order_release); }
+
+    template <typename... Args>
+    static void FormatEntry(char* buffer, size_t bufferSize, const char* format, const u8* args)
+    {
+        if constexpr (sizeof...(Args) == 0)
+        {
+            snprintf(buffer, bufferSize, "%s", format);
+        }
+        else
+        {
+            const std::tuple<Args...>& argTuple = *std::launder(reinterpret_cast<const std::tuple<Args...>*>(args));
+            std::apply([&](Args... unpackedArgs) { snprintf(buffer, bufferSize, format, unpackedArgs...); }, argTuple);
+        }
+    }
+};
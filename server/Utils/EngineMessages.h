@@ -0,0 +1,131 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Utils/Message.h>
+#include <cassert>
+#include "AsyncLogger.h"
+
+struct Packet;
+struct PasswordProofBatchResult;
+
+// The queues of an EngineLoop carry these instead of the network library's Message, they are fixed size and trivially copyable
+// so passing one never allocates: disconnects carry the identity inline and prints carry their text inline.
+// The network library's messages are converted once, by the EngineLoopGroup router, see FromMessage.
+enum class EngineInputType : u8
+{
+    NONE,
+    EXIT,
+    PING,
+    CLIENT_PACKET, // packet
+    INTERNAL_PACKET, // packet
+    DISCONNECT, // identity
+    CRYPTO_RESULT // cryptoResult, owned by the receiver
+};
+
+struct EngineInputMessage
+{
+    EngineInputType type = EngineInputType::NONE;
+    union
+    {
+        Packet* packet;
+        u64 identity;
+        PasswordProofBatchResult* cryptoResult;
+    };
+    u64 receivedNS = 0; // When the router took it off the network library's queue, only stamped while packets are captured
+
+    EngineInputMessage() : identity(0) { }
+    explicit EngineInputMessage(EngineInputType inType) : type(inType), identity(0) { }
+
+    static EngineInputMessage ClientPacket(Packet* packet)
+    {
+        EngineInputMessage message(EngineInputType::CLIENT_PACKET);
+        message.packet = packet;
+        return message;
+    }
+    static EngineInputMessage InternalPacket(Packet* packet)
+    {
+        EngineInputMessage message(EngineInputType::INTERNAL_PACKET);
+        message.packet = packet;
+        return message;
+    }
+    static EngineInputMessage Disconnect(u64 identity)
+    {
+        EngineInputMessage message(EngineInputType::DISCONNECT);
+        message.identity = identity;
+        return message;
+    }
+    static EngineInputMessage CryptoResult(PasswordProofBatchResult* cryptoResult)
+    {
+        EngineInputMessage message(EngineInputType::CRYPTO_RESULT);
+        message.cryptoResult = cryptoResult;
+        return message;
+    }
+
+    // Takes over whatever the network library allocated for the message, returns NONE for codes the engine doesn't handle.
+    // Every code the network library sends has to be handled here, an unknown one can't be freed and asserts
+    static EngineInputMessage FromMessage(Message& message)
+    {
+        switch (message.code)
+        {
+            case MSG_IN_EXIT:
+                return EngineInputMessage(EngineInputType::EXIT);
+            case MSG_IN_PING:
+                return EngineInputMessage(EngineInputType::PING);
+            case MSG_IN_NET_PACKET:
+                return ClientPacket(static_cast<Packet*>(message.object));
+            case MSG_IN_INTERNAL_NET_PACKET:
+                return InternalPacket(static_cast<Packet*>(message.object));
+            case MSG_IN_NET_DISCONNECT:
+            {
+                u64* identity = static_cast<u64*>(message.object);
+                EngineInputMessage disconnectMessage = Disconnect(*identity);
+                delete identity;
+                return disconnectMessage;
+            }
+        }
+
+        NC_ASYNC_LOG_CRITICAL("Unhandled message code %d, whatever it carried is leaked", message.code);
+        assert(false);
+        return EngineInputMessage();
+    }
+};
+
+enum class EngineOutputType : u8
+{
+    NONE,
+    EXIT_CONFIRM,
+    PRINT // text
+};
+
+struct EngineOutputMessage
+{
+    static constexpr size_t MAX_TEXT_SIZE = 255;
+
+    EngineOutputType type = EngineOutputType::NONE;
+    char text[MAX_TEXT_SIZE] = {}; // Always null terminated, longer prints are cut off
+
+    EngineOutputMessage() { }
+    explicit EngineOutputMessage(EngineOutputType inType) : type(inType) { }
+};
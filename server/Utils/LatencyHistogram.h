@@ -0,0 +1,142 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <atomic>
+
+// Log-linear histogram in the style of HdrHistogram, every power of two is split into SUB_BUCKET_COUNT buckets
+// so any recorded value is reported within ~6% of what was recorded. Record is wait free and may be called from any thread.
+class LatencyHistogram
+{
+public:
+    static constexpr u32 SUB_BUCKET_BITS = 4;
+    static constexpr u32 SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr u32 BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    LatencyHistogram() { Reset(); }
+
+    void Record(u64 value)
+    {
+        _buckets[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+
+        u64 max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+    }
+
+    // Not synchronized with Record, values recorded while this runs may or may not be kept
+    void Reset()
+    {
+        for (std::atomic<u64>& bucket : _buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        _count.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    void Merge(const LatencyHistogram& other)
+    {
+        for (u32 i = 0; i < BUCKET_COUNT; i++)
+        {
+            if (u64 count = other._buckets[i].load(std::memory_order_relaxed))
+                _buckets[i].fetch_add(count, std::memory_order_relaxed);
+        }
+        _count.fetch_add(other.GetCount(), std::memory_order_relaxed);
+        _sum.fetch_add(other._sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        u64 otherMax = other.GetMax();
+        u64 max = _max.load(std::memory_order_relaxed);
+        while (otherMax > max && !_max.compare_exchange_weak(max, otherMax, std::memory_order_relaxed)) { }
+    }
+
+    u64 GetCount() const { return _count.load(std::memory_order_relaxed); }
+    u64 GetMax() const { return _max.load(std::memory_order_relaxed); }
+    u64 GetMean() const
+    {
+        u64 count = GetCount();
+        return count ? _sum.load(std::memory_order_relaxed) / count : 0;
+    }
+
+    // percentile in [0, 100], returns the middle of the bucket holding it
+    u64 GetPercentile(f64 percentile) const
+    {
+        u64 count = GetCount();
+        if (count == 0)
+            return 0;
+
+        u64 target = static_cast<u64>((percentile / 100.0) * static_cast<f64>(count) + 0.5);
+        target = target < 1 ? 1 : (target > count ? count : target);
+
+        u64 seen = 0;
+        for (u32 i = 0; i < BUCKET_COUNT; i++)
+        {
+            seen += _buckets[i].load(std::memory_order_relaxed);
+            if (seen >= target)
+            {
+                u64 middle = GetBucketLowerBound(i) + GetBucketWidth(i) / 2;
+                u64 max = GetMax();
+                return middle < max ? middle : max;
+            }
+        }
+
+        return GetMax();
+    }
+
+private:
+    static u32 GetBucketIndex(u64 value)
+    {
+        if (value < SUB_BUCKET_COUNT)
+            return static_cast<u32>(value);
+
+        u32 highestBit = 63;
+        while (!(value >> highestBit))
+        {
+            highestBit--;
+        }
+
+        u32 shift = highestBit - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKET_COUNT + static_cast<u32>((value >> shift) & (SUB_BUCKET_COUNT - 1));
+    }
+    static u64 GetBucketLowerBound(u32 index)
+    {
+        if (index < SUB_BUCKET_COUNT)
+            return index;
+
+        u32 shift = index / SUB_BUCKET_COUNT - 1;
+        return static_cast<u64>(SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) << shift;
+    }
+    static u64 GetBucketWidth(u32 index)
+    {
+        return index < SUB_BUCKET_COUNT ? 1 : 1ull << (index / SUB_BUCKET_COUNT - 1);
+    }
+
+private:
+    std::atomic<u64> _buckets[BUCKET_COUNT];
+    std::atomic<u64> _count;
+    std::atomic<u64> _sum;
+    std::atomic<u64> _max;
+};
@@ -0,0 +1,243 @@
+#include "Metrics.h"
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    // Blocks of threads that exited are kept so their counts stay in the totals
+    struct MetricsRegistry
+    {
+        ~MetricsRegistry()
+        {
+            if (!dumpThread.joinable())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(dumpMutex);
+                stopDumping = true;
+            }
+            dumpCondition.notify_all();
+            dumpThread.join();
+        }
+
+        std::mutex mutex;
+        std::vector<std::unique_ptr<MetricsThreadBlock>> threadBlocks;
+
+        std::mutex dumpMutex;
+        std::condition_variable dumpCondition;
+        std::thread dumpThread;
+        bool stopDumping = false;
+    };
+
+    MetricsRegistry& GetRegistry()
+    {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    const char* counterNames[METRIC_COUNTER_COUNT] =
+    {
+        "packets_received",
+        "internal_packets_received",
+        "packets_dropped",
+        "packets_shed",
+        "connections_shed",
+        "packets_rate_limited",
+        "logins_rate_limited",
+        "connections_opened",
+        "connections_closed",
+        "connections_timed_out",
+        "sessions_validated",
+        "sessions_rejected",
+        "realm_joins_assigned",
+        "realm_joins_queued",
+        "log_messages_dropped"
+    };
+
+    const char* gaugeNames[METRIC_GAUGE_COUNT] =
+    {
+        "input_queue_depth",
+        "output_queue_depth",
+        "internal_lane_depth",
+        "client_lane_depth",
+        "client_connections",
+        "internal_connections",
+        "load_shedding",
+        "realm_queue_length"
+    };
+
+    const char* histogramNames[METRIC_HISTOGRAM_COUNT] =
+    {
+        "handler_time_ns",
+        "tick_duration_ns"
+    };
+}
+
+thread_local MetricsThreadBlock* Metrics::_threadMetrics = nullptr;
+
+MetricsThreadBlock& Metrics::RegisterThread()
+{
+    MetricsRegistry& registry = GetRegistry();
+    MetricsThreadBlock* threadMetrics = new MetricsThreadBlock();
+
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threadBlocks.emplace_back(threadMetrics);
+
+    _threadMetrics = threadMetrics;
+    return *threadMetrics;
+}
+
+void Metrics::GetSnapshot(MetricsSnapshot& snapshot)
+{
+    MetricsRegistry& registry = GetRegistry();
+
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& threadBlock : registry.threadBlocks)
+    {
+        const MetricsThreadBlock* threadMetrics = threadBlock.get();
+
+        for (u32 i = 0; i < METRIC_COUNTER_COUNT; i++)
+            snapshot.counters[i] += threadMetrics->counters[i].load(std::memory_order_relaxed);
+
+        for (u32 i = 0; i < METRIC_OPCODE_SLOTS; i++)
+            snapshot.opcodePackets[i] += threadMetrics->opcodePackets[i].load(std::memory_order_relaxed);
+
+        for (u32 i = 0; i < METRIC_HISTOGRAM_COUNT; i++)
+            snapshot.histograms[i].Merge(threadMetrics->histograms[i]);
+
+        for (u32 i = 0; i < METRIC_GAUGE_COUNT; i++)
+        {
+            snapshot.gauges[i] += threadMetrics->gauges[i].load(std::memory_order_relaxed);
+            snapshot.gaugeMaxima[i] += threadMetrics->gaugeMaxima[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Metrics::Reset()
+{
+    MetricsRegistry& registry = GetRegistry();
+
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& threadBlock : registry.threadBlocks)
+    {
+        MetricsThreadBlock* threadMetrics = threadBlock.get();
+
+        for (std::atomic<u64>& counter : threadMetrics->counters)
+            counter.store(0, std::memory_order_relaxed);
+
+        for (std::atomic<u64>& opcodePackets : threadMetrics->opcodePackets)
+            opcodePackets.store(0, std::memory_order_relaxed);
+
+        for (LatencyHistogram& histogram : threadMetrics->histograms)
+            histogram.Reset();
+
+        for (u32 i = 0; i < METRIC_GAUGE_COUNT; i++)
+            threadMetrics->gaugeMaxima[i].store(threadMetrics->gauges[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+void Metrics::FormatSnapshot(const MetricsSnapshot& snapshot, std::vector<std::string>& lines)
+{
+    char line[128];
+
+    for (u32 i = 0; i < METRIC_COUNTER_COUNT; i++)
+    {
+        snprintf(line, sizeof(line), "%s %llu", counterNames[i], static_cast<unsigned long long>(snapshot.counters[i]));
+        lines.push_back(line);
+    }
+
+    for (u32 i = 0; i < METRIC_OPCODE_SLOTS; i++)
+    {
+        if (snapshot.opcodePackets[i] == 0)
+            continue;
+
+        if (i < OPCODE_MAX_COUNT)
+            snprintf(line, sizeof(line), "opcode_packets.%u %llu", i, static_cast<unsigned long long>(snapshot.opcodePackets[i]));
+        else
+            snprintf(line, sizeof(line), "opcode_packets.unknown %llu", static_cast<unsigned long long>(snapshot.opcodePackets[i]));
+        lines.push_back(line);
+    }
+
+    for (u32 i = 0; i < METRIC_GAUGE_COUNT; i++)
+    {
+        snprintf(line, sizeof(line), "%s %llu", gaugeNames[i], static_cast<unsigned long long>(snapshot.gauges[i]));
+        lines.push_back(line);
+        snprintf(line, sizeof(line), "%s.max %llu", gaugeNames[i], static_cast<unsigned long long>(snapshot.gaugeMaxima[i]));
+        lines.push_back(line);
+    }
+
+    for (u32 i = 0; i < METRIC_HISTOGRAM_COUNT; i++)
+    {
+        const LatencyHistogram& histogram = snapshot.histograms[i];
+        snprintf(line, sizeof(line), "%s.count %llu", histogramNames[i], static_cast<unsigned long long>(histogram.GetCount()));
+        lines.push_back(line);
+        snprintf(line, sizeof(line), "%s.mean %llu", histogramNames[i], static_cast<unsigned long long>(histogram.GetMean()));
+        lines.push_back(line);
+        snprintf(line, sizeof(line), "%s.p50 %llu", histogramNames[i], static_cast<unsigned long long>(histogram.GetPercentile(50.0)));
+        lines.push_back(line);
+        snprintf(line, sizeof(line), "%s.p99 %llu", histogramNames[i], static_cast<unsigned long long>(histogram.GetPercentile(99.0)));
+        lines.push_back(line);
+        snprintf(line, sizeof(line), "%s.p999 %llu", histogramNames[i], static_cast<unsigned long long>(histogram.GetPercentile(99.9)));
+        lines.push_back(line);
+        snprintf(line, sizeof(line), "%s.max %llu", histogramNames[i], static_cast<unsigned long long>(histogram.GetMax()));
+        lines.push_back(line);
+    }
+}
+
+bool Metrics::StartDumping(const std::string& path, std::chrono::seconds interval)
+{
+    StopDumping();
+
+    // Fail early on paths we can't write to instead of silently dumping nothing
+    FILE* file = std::fopen(path.c_str(), "a");
+    if (!file)
+        return false;
+    std::fclose(file);
+
+    MetricsRegistry& registry = GetRegistry();
+    registry.stopDumping = false;
+    registry.dumpThread = std::thread([path, interval]()
+    {
+        MetricsRegistry& registry = GetRegistry();
+        std::unique_lock<std::mutex> lock(registry.dumpMutex);
+
+        while (!registry.dumpCondition.wait_for(lock, interval, [&registry]() { return registry.stopDumping; }))
+        {
+            MetricsSnapshot snapshot;
+            GetSnapshot(snapshot);
+
+            std::vector<std::string> lines;
+            FormatSnapshot(snapshot, lines);
+
+            FILE* file = std::fopen(path.c_str(), "a");
+            if (!file)
+                continue;
+
+            u64 timestamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            std::fprintf(file, "# timestamp %llu\n", static_cast<unsigned long long>(timestamp));
+            for (const std::string& line : lines)
+                std::fprintf(file, "%s\n", line.c_str());
+
+            std::fclose(file);
+        }
+    });
+
+    return true;
+}
+
+void Metrics::StopDumping()
+{
+    MetricsRegistry& registry = GetRegistry();
+    if (!registry.dumpThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(registry.dumpMutex);
+        registry.stopDumping = true;
+    }
+    registry.dumpCondition.notify_all();
+    registry.dumpThread.join();
+}
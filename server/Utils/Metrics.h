@@ -0,0 +1,153 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "LatencyHistogram.h"
+#include "../Networking/Opcodes.h"
+
+enum class MetricCounter : u8
+{
+    PACKETS_RECEIVED,
+    INTERNAL_PACKETS_RECEIVED,
+    PACKETS_DROPPED,
+    PACKETS_SHED, // Client packets turned away while a shard is over its high watermark or its input queue is full
+    CONNECTIONS_SHED, // Connections closed for flooding their packet queue while a shard is shedding
+    PACKETS_RATE_LIMITED, // Client packets over their address' limit or from a banned address
+    LOGINS_RATE_LIMITED, // Logins failed because their account is banned after too many failed attempts
+    CONNECTIONS_OPENED,
+    CONNECTIONS_CLOSED,
+    CONNECTIONS_TIMED_OUT, // Handshake deadline or session expiry
+    SESSIONS_VALIDATED, // Session keys world servers asked about that matched
+    SESSIONS_REJECTED,
+    REALM_JOINS_ASSIGNED,
+    REALM_JOINS_QUEUED, // Every instance of the realm was full
+    LOG_MESSAGES_DROPPED, // The AsyncLogger ring was full
+    COUNT
+};
+
+// Sampled once per tick by every engine shard, a snapshot sums the shards up
+enum class MetricGauge : u8
+{
+    INPUT_QUEUE_DEPTH,
+    OUTPUT_QUEUE_DEPTH,
+    INTERNAL_LANE_DEPTH,
+    CLIENT_LANE_DEPTH,
+    CLIENT_CONNECTIONS,
+    INTERNAL_CONNECTIONS,
+    LOAD_SHEDDING, // Shards that are shedding new connections
+    REALM_QUEUE_LENGTH,
+    COUNT
+};
+
+// Recorded in nanoseconds
+enum class MetricHistogram : u8
+{
+    HANDLER_TIME,
+    TICK_DURATION,
+    COUNT
+};
+
+constexpr u32 METRIC_COUNTER_COUNT = static_cast<u32>(MetricCounter::COUNT);
+constexpr u32 METRIC_GAUGE_COUNT = static_cast<u32>(MetricGauge::COUNT);
+constexpr u32 METRIC_HISTOGRAM_COUNT = static_cast<u32>(MetricHistogram::COUNT);
+constexpr u32 METRIC_OPCODE_SLOTS = OPCODE_MAX_COUNT + 1; // The last slot counts opcodes outside of the Opcode enum
+
+// Written only by the thread that owns it, see Metrics
+struct alignas(64) MetricsThreadBlock
+{
+    std::atomic<u64> counters[METRIC_COUNTER_COUNT] = {};
+    std::atomic<u64> opcodePackets[METRIC_OPCODE_SLOTS] = {};
+    LatencyHistogram histograms[METRIC_HISTOGRAM_COUNT];
+    std::atomic<u64> gauges[METRIC_GAUGE_COUNT] = {};
+    std::atomic<u64> gaugeMaxima[METRIC_GAUGE_COUNT] = {};
+};
+
+struct MetricsSnapshot
+{
+    u64 counters[METRIC_COUNTER_COUNT] = {};
+    u64 opcodePackets[METRIC_OPCODE_SLOTS] = {};
+    u64 gauges[METRIC_GAUGE_COUNT] = {};
+    u64 gaugeMaxima[METRIC_GAUGE_COUNT] = {}; // Sum of every shard's maximum
+    LatencyHistogram histograms[METRIC_HISTOGRAM_COUNT];
+};
+
+// Always-on counters and histograms. Every thread writes to its own block so recording never contends,
+// the blocks are only summed up when somebody asks for a snapshot.
+class Metrics
+{
+public:
+    static void Increment(MetricCounter counter, u64 amount = 1)
+    {
+        AddToOwnCounter(GetThreadMetrics().counters[static_cast<u32>(counter)], amount);
+    }
+    static void IncrementOpcode(u32 opcode)
+    {
+        AddToOwnCounter(GetThreadMetrics().opcodePackets[opcode < OPCODE_MAX_COUNT ? opcode : OPCODE_MAX_COUNT], 1);
+    }
+    static void Record(MetricHistogram histogram, u64 valueNS)
+    {
+        GetThreadMetrics().histograms[static_cast<u32>(histogram)].Record(valueNS);
+    }
+    static void SetGauge(MetricGauge gauge, u64 value)
+    {
+        MetricsThreadBlock& threadMetrics = GetThreadMetrics();
+        u32 index = static_cast<u32>(gauge);
+
+        threadMetrics.gauges[index].store(value, std::memory_order_relaxed);
+        if (value > threadMetrics.gaugeMaxima[index].load(std::memory_order_relaxed))
+            threadMetrics.gaugeMaxima[index].store(value, std::memory_order_relaxed);
+    }
+
+    static void GetSnapshot(MetricsSnapshot& snapshot);
+
+    // Not synchronized with recording threads, meant for benchmarks between runs
+    static void Reset();
+
+    // One "name value" line per metric, used by the stats command and the periodic dump
+    static void FormatSnapshot(const MetricsSnapshot& snapshot, std::vector<std::string>& lines);
+
+    // Appends a snapshot to the file every interval from a background thread until StopDumping
+    static bool StartDumping(const std::string& path, std::chrono::seconds interval);
+    static void StopDumping();
+
+private:
+    // Only the owning thread writes its counters, so a plain load and store is enough and avoids a locked add
+    static void AddToOwnCounter(std::atomic<u64>& counter, u64 amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static MetricsThreadBlock& GetThreadMetrics()
+    {
+        MetricsThreadBlock* threadMetrics = _threadMetrics;
+        return threadMetrics ? *threadMetrics : RegisterThread();
+    }
+    static MetricsThreadBlock& RegisterThread();
+
+    static thread_local MetricsThreadBlock* _threadMetrics;
+};
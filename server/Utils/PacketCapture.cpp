@@ -0,0 +1,295 @@
+#include "PacketCapture.h"
+#include "AsyncLogger.h"
+#include "../ECS/Components/Singletons/TimeSingleton.h"
+#include <Networking/Packet.h>
+#include <Networking/Connection.h>
+#include <Utils/ByteBuffer.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    size_t GetPaddedPayloadSize(u32 payloadSize)
+    {
+        return (payloadSize + PacketCaptureRecord::RECORD_ALIGNMENT - 1) & ~static_cast<size_t>(PacketCaptureRecord::RECORD_ALIGNMENT - 1);
+    }
+}
+
+bool PacketCaptureWriter::Start(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_file)
+        return false;
+
+    _file = std::fopen(path.c_str(), "wb");
+    if (!_file)
+        return false;
+
+    PacketCaptureFileHeader header;
+    header.startTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    if (std::fwrite(&header, sizeof(header), 1, _file) != 1)
+    {
+        std::fclose(_file);
+        _file = nullptr;
+        return false;
+    }
+
+    _recordCount.store(0, std::memory_order_relaxed);
+    _startTimeNS.store(TimeSingleton::Now(), std::memory_order_relaxed);
+    _session.fetch_add(1, std::memory_order_release);
+    _isCapturing.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void PacketCaptureWriter::Stop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_file)
+        return;
+
+    _isCapturing.store(false, std::memory_order_relaxed);
+    std::fclose(_file);
+    _file = nullptr;
+}
+
+void PacketCaptureWriter::Append(u32 session, const std::vector<u8>& records, u64 recordCount)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_file || session != _session.load(std::memory_order_relaxed))
+        return;
+
+    // A short write leaves a record cut off, the reader stops there, so nothing may be appended after it
+    if (std::fwrite(records.data(), 1, records.size(), _file) != records.size())
+    {
+        NC_ASYNC_LOG_CRITICAL("Packet capture stopped, writing %llu records failed (errno %d)", static_cast<unsigned long long>(recordCount), errno);
+        _isCapturing.store(false, std::memory_order_relaxed);
+        std::fclose(_file);
+        _file = nullptr;
+        return;
+    }
+
+    _recordCount.fetch_add(recordCount, std::memory_order_relaxed);
+}
+
+bool PacketCaptureRecorder::Begin(PacketCaptureWriter* writer)
+{
+    if (!writer || !writer->IsCapturing())
+    {
+        _writer = nullptr;
+        return false;
+    }
+
+    // A new capture starts with new connection ids
+    u32 session = writer->GetSession();
+    if (_writer != writer || _session != session)
+    {
+        _writer = writer;
+        _session = session;
+        _startTimeNS = writer->GetStartTimeNS();
+        _nextConnectionId = 0;
+        _records.clear();
+        _recordCount = 0;
+        _connectionIds.clear();
+        _identities.clear();
+    }
+
+    return true;
+}
+
+void PacketCaptureRecorder::RecordPacket(PacketCaptureType type, const Packet& packet, u64 receivedNS)
+{
+    const u8* payload;
+    u32 payloadSize;
+    GetPacketPayload(packet, payload, payloadSize);
+
+    AppendRecord(type, GetConnectionId(packet), static_cast<u16>(packet.header.opcode), payload, payloadSize, receivedNS);
+}
+
+void PacketCaptureRecorder::RecordDisconnect(u64 identity, u64 receivedNS)
+{
+    // Connections that didn't send anything since the capture started have nothing to replay
+    auto itr = _identities.find(identity);
+    if (itr == _identities.end())
+        return;
+
+    AppendRecord(PacketCaptureType::DISCONNECT, itr->second, 0, nullptr, 0, receivedNS);
+    _identities.erase(itr);
+}
+
+void PacketCaptureRecorder::BindIdentity(const Packet& packet, u64 identity)
+{
+    auto itr = _connectionIds.find(&*packet.connection);
+    if (itr == _connectionIds.end())
+        return;
+
+    _identities[identity] = itr->second;
+    _connectionIds.erase(itr);
+}
+
+void PacketCaptureRecorder::ForgetConnection(const Packet& packet)
+{
+    _connectionIds.erase(&*packet.connection);
+}
+
+void PacketCaptureRecorder::Flush()
+{
+    if (!_writer || _records.empty())
+        return;
+
+    _writer->Append(_session, _records, _recordCount);
+    _records.clear();
+    _recordCount = 0;
+}
+
+u64 PacketCaptureRecorder::GetConnectionId(const Packet& packet)
+{
+    if (u64 identity = packet.connection->GetIdentity())
+    {
+        auto result = _identities.emplace(identity, 0);
+        if (result.second)
+            result.first->second = MakeConnectionId();
+
+        return result.first->second;
+    }
+
+    auto result = _connectionIds.emplace(&*packet.connection, 0);
+    if (result.second)
+        result.first->second = MakeConnectionId();
+
+    return result.first->second;
+}
+
+void PacketCaptureRecorder::AppendRecord(PacketCaptureType type, u64 connectionId, u16 opcode, const u8* payload, u32 payloadSize, u64 receivedNS)
+{
+    PacketCaptureRecord record;
+    record.timeNS = receivedNS > _startTimeNS ? receivedNS - _startTimeNS : 0;
+    record.connectionId = connectionId;
+    record.type = type;
+    record.opcode = opcode;
+    record.payloadSize = payloadSize;
+
+    size_t offset = _records.size();
+    _records.resize(offset + sizeof(record) + GetPaddedPayloadSize(payloadSize));
+    memcpy(&_records[offset], &record, sizeof(record));
+    if (payloadSize)
+        memcpy(&_records[offset + sizeof(record)], payload, payloadSize);
+
+    _recordCount++;
+}
+
+bool PacketCaptureReader::Open(const std::string& path)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!data)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    _fileHandle = file;
+    _mappingHandle = mapping;
+    _data = static_cast<const u8*>(data);
+    _size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    i32 file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat fileStat;
+    void* data = fstat(file, &fileStat) == 0 && fileStat.st_size > 0 ? mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+    close(file);
+    if (data == MAP_FAILED)
+        return false;
+
+    _data = static_cast<const u8*>(data);
+    _size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    if (_size < sizeof(PacketCaptureFileHeader) || GetHeader().magic != PacketCaptureFileHeader::MAGIC || GetHeader().version != PacketCaptureFileHeader::VERSION)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void PacketCaptureReader::Close()
+{
+    if (!_data)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+    CloseHandle(_mappingHandle);
+    CloseHandle(_fileHandle);
+    _fileHandle = nullptr;
+    _mappingHandle = nullptr;
+#else
+    munmap(const_cast<u8*>(_data), _size);
+#endif
+
+    _data = nullptr;
+    _size = 0;
+}
+
+bool PacketCaptureReader::Next(size_t& offset, const PacketCaptureRecord*& record, const u8*& payload) const
+{
+    if (offset < sizeof(PacketCaptureFileHeader))
+        offset = sizeof(PacketCaptureFileHeader);
+
+    if (offset + sizeof(PacketCaptureRecord) > _size)
+        return false;
+
+    const PacketCaptureRecord* nextRecord = reinterpret_cast<const PacketCaptureRecord*>(_data + offset);
+    size_t recordSize = sizeof(PacketCaptureRecord) + GetPaddedPayloadSize(nextRecord->payloadSize);
+    if (offset + recordSize > _size)
+        return false;
+
+    record = nextRecord;
+    payload = _data + offset + sizeof(PacketCaptureRecord);
+    offset += recordSize;
+    return true;
+}
+
+void GetPacketPayload(const Packet& packet, const u8*& data, u32& size)
+{
+    if (!packet.payload)
+    {
+        data = nullptr;
+        size = 0;
+        return;
+    }
+
+    data = packet.payload->GetDataPointer();
+    size = static_cast<u32>(packet.payload->writtenData);
+}
+
+void SetPacketPayload(Packet& packet, const u8* data, u32 size)
+{
+    packet.payload = std::make_shared<Bytebuffer>(nullptr, size);
+    packet.payload->PutBytes(const_cast<u8*>(data), size);
+    packet.header.size = static_cast<u16>(size);
+}
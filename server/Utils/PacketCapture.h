@@ -0,0 +1,162 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Packet;
+class Connection;
+
+// Capture files are a PacketCaptureFileHeader followed by records, every record is a PacketCaptureRecord followed by its payload
+// padded to RECORD_ALIGNMENT bytes, so a mapped file can be walked in place. Integers are stored in the byte order of the machine
+// that captured. Every engine shard appends its records once per tick, records of different shards can be slightly out of order.
+enum class PacketCaptureType : u16
+{
+    CLIENT_PACKET,
+    INTERNAL_PACKET,
+    DISCONNECT
+};
+
+struct PacketCaptureFileHeader
+{
+    static constexpr u32 MAGIC = 0x50434E4E; // "NNCP"
+    static constexpr u32 VERSION = 1;
+
+    u32 magic = MAGIC;
+    u32 version = VERSION;
+    u64 startTime = 0; // Seconds since the unix epoch, informational only
+};
+
+struct PacketCaptureRecord
+{
+    static constexpr u32 RECORD_ALIGNMENT = 8;
+
+    u64 timeNS; // When the router received it, since the capture started
+    u64 connectionId; // The same for every record of a connection within one capture
+    PacketCaptureType type;
+    u16 opcode;
+    u32 payloadSize;
+};
+
+static_assert(sizeof(PacketCaptureFileHeader) == 16 && sizeof(PacketCaptureRecord) == 24, "The capture format may not change with the compiler");
+
+// The capture file, shared by every engine shard. Thread safe
+class PacketCaptureWriter
+{
+public:
+    ~PacketCaptureWriter() { Stop(); }
+
+    bool Start(const std::string& path);
+    void Stop();
+
+    bool IsCapturing() const { return _isCapturing.load(std::memory_order_relaxed); }
+
+    // Bumped by every Start, records a shard buffered for an earlier capture are thrown away
+    u32 GetSession() const { return _session.load(std::memory_order_acquire); }
+    u64 GetStartTimeNS() const { return _startTimeNS.load(std::memory_order_relaxed); }
+
+    void Append(u32 session, const std::vector<u8>& records, u64 recordCount);
+    u64 GetRecordCount() const { return _recordCount.load(std::memory_order_relaxed); }
+
+private:
+    std::mutex _mutex;
+    FILE* _file = nullptr;
+    std::atomic<bool> _isCapturing{ false };
+    std::atomic<u32> _session{ 0 };
+    std::atomic<u64> _startTimeNS{ 0 };
+    std::atomic<u64> _recordCount{ 0 };
+};
+
+// Buffers the records of one engine shard for a tick, connections are given capture ids that stay the same
+// across the identity the shard tags them with. A connection without an identity is only known by its address until the shard
+// either tags it (BindIdentity) or drops its packet (ForgetConnection), so memory the network library reuses for a later
+// connection is never taken for the old one. Not thread safe
+class PacketCaptureRecorder
+{
+public:
+    PacketCaptureRecorder(u32 shardIndex) : _shardIndex(shardIndex) { }
+
+    // Called at the start of a tick, returns false while nothing is being captured
+    bool Begin(PacketCaptureWriter* writer);
+
+    void RecordPacket(PacketCaptureType type, const Packet& packet, u64 receivedNS);
+    void RecordDisconnect(u64 identity, u64 receivedNS);
+
+    // The shard tagged the connection of packet with identity, its disconnect only carries the identity
+    void BindIdentity(const Packet& packet, u64 identity);
+
+    // The shard dropped the packet of a connection it didn't tag, the next packet of it is recorded as a new connection
+    void ForgetConnection(const Packet& packet);
+
+    void Flush();
+
+private:
+    u64 GetConnectionId(const Packet& packet);
+    u64 MakeConnectionId() { return (static_cast<u64>(_shardIndex + 1) << 32) | _nextConnectionId++; }
+    void AppendRecord(PacketCaptureType type, u64 connectionId, u16 opcode, const u8* payload, u32 payloadSize, u64 receivedNS);
+
+private:
+    u32 _shardIndex;
+    PacketCaptureWriter* _writer = nullptr;
+    u32 _session = 0;
+    u64 _startTimeNS = 0;
+    u32 _nextConnectionId = 0;
+
+    std::vector<u8> _records;
+    u64 _recordCount = 0;
+    std::unordered_map<const Connection*, u64> _connectionIds; // Connections the shard hasn't tagged yet
+    std::unordered_map<u64, u64> _identities;
+};
+
+// Maps a capture file read only
+class PacketCaptureReader
+{
+public:
+    ~PacketCaptureReader() { Close(); }
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const PacketCaptureFileHeader& GetHeader() const { return *reinterpret_cast<const PacketCaptureFileHeader*>(_data); }
+
+    // Walks the records in file order starting at offset 0, returns false at the end of the file or at a record cut off by a crash
+    bool Next(size_t& offset, const PacketCaptureRecord*& record, const u8*& payload) const;
+
+private:
+    const u8* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void* _fileHandle = nullptr;
+    void* _mappingHandle = nullptr;
+#endif
+};
+
+// The two places that know how the network library stores a payload
+void GetPacketPayload(const Packet& packet, const u8*& data, u32& size);
+void SetPacketPayload(Packet& packet, const u8* data, u32 size);
@@ -0,0 +1,97 @@
+#include "PacketPool.h"
+#include <Networking/Packet.h>
+#include <Utils/ConcurrentQueue.h>
+#include <atomic>
+#include <new>
+
+namespace
+{
+    struct PacketPoolDepot
+    {
+        PacketPoolDepot() : storage(PacketPool::MAX_DEPOT_SIZE), size(0) { }
+        ~PacketPoolDepot()
+        {
+            void* block;
+            while (storage.try_dequeue(block))
+            {
+                ::operator delete(block);
+            }
+        }
+
+        moodycamel::ConcurrentQueue<void*> storage;
+        std::atomic<i64> size;
+    };
+
+    PacketPoolDepot& GetDepot()
+    {
+        static PacketPoolDepot depot;
+        return depot;
+    }
+
+    struct PacketPoolThreadCache
+    {
+        ~PacketPoolThreadCache()
+        {
+            PacketPoolDepot& depot = GetDepot();
+            depot.storage.enqueue_bulk(blocks, count);
+            depot.size.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void* blocks[PacketPool::THREAD_CACHE_SIZE];
+        u32 count = 0;
+    };
+
+    thread_local PacketPoolThreadCache threadCache;
+}
+
+Packet* PacketPool::Acquire()
+{
+    PacketPoolDepot& depot = GetDepot();
+
+    if (threadCache.count == 0)
+    {
+        size_t taken = depot.storage.try_dequeue_bulk(threadCache.blocks, THREAD_CACHE_SIZE / 2);
+        depot.size.fetch_sub(static_cast<i64>(taken), std::memory_order_relaxed);
+        threadCache.count = static_cast<u32>(taken);
+    }
+
+    void* block = threadCache.count > 0 ? threadCache.blocks[--threadCache.count] : ::operator new(sizeof(Packet));
+
+    return new (block) Packet();
+}
+
+void PacketPool::Release(Packet* packet)
+{
+    if (!packet)
+        return;
+
+    packet->~Packet();
+
+    if (threadCache.count == THREAD_CACHE_SIZE)
+    {
+        PacketPoolDepot& depot = GetDepot();
+
+        // Hand the older half to the depot so other threads can pick it up
+        constexpr u32 halfCacheSize = THREAD_CACHE_SIZE / 2;
+        if (depot.size.load(std::memory_order_relaxed) + halfCacheSize <= MAX_DEPOT_SIZE)
+        {
+            depot.storage.enqueue_bulk(threadCache.blocks, halfCacheSize);
+            depot.size.fetch_add(halfCacheSize, std::memory_order_relaxed);
+        }
+        else
+        {
+            for (u32 i = 0; i < halfCacheSize; i++)
+            {
+                ::operator delete(threadCache.blocks[i]);
+            }
+        }
+
+        for (u32 i = halfCacheSize; i < THREAD_CACHE_SIZE; i++)
+        {
+            threadCache.blocks[i - halfCacheSize] = threadCache.blocks[i];
+        }
+        threadCache.count = halfCacheSize;
+    }
+
+    threadCache.blocks[threadCache.count++] = packet;
+}
@@ -0,0 +1,43 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+
+struct Packet;
+
+// Recycles Packet storage so a packet released on a taskflow worker can be reused by whichever thread acquires next.
+// Every thread keeps a small cache and trades half of it with a shared depot when it runs full or empty.
+// Only the benches and the replay tool acquire their packets here, the network library allocates with plain new Packet().
+// In the server Release just frees a packet once the depot is full, so there is nothing worth counting there
+class PacketPool
+{
+public:
+    static Packet* Acquire();
+
+    // Destroys the packet and keeps its storage, packets allocated with plain new Packet() may be released here as well
+    static void Release(Packet* packet);
+
+    static constexpr u32 THREAD_CACHE_SIZE = 64;
+    static constexpr u32 MAX_DEPOT_SIZE = 16384;
+};
@@ -0,0 +1,99 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <atomic>
+#include <utility>
+
+// Fixed capacity single producer / single consumer queue, Push may only be called from one thread and Peek/Pop/TryPop from one other thread.
+// Moving is not thread safe, it exists so the buffer can live inside entt components that get moved around by the registry.
+template <typename T, u32 Capacity>
+class SPSCRingBuffer
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SPSCRingBuffer capacity must be a power of two");
+
+public:
+    SPSCRingBuffer() : _head(0), _tail(0) { }
+    SPSCRingBuffer(SPSCRingBuffer&& other) noexcept { *this = std::move(other); }
+    SPSCRingBuffer& operator=(SPSCRingBuffer&& other) noexcept
+    {
+        u32 head = other._head.load(std::memory_order_relaxed);
+        u32 tail = other._tail.load(std::memory_order_relaxed);
+        for (u32 i = head; i != tail; i++)
+        {
+            _buffer[i & MASK] = std::move(other._buffer[i & MASK]);
+        }
+
+        _head.store(head, std::memory_order_relaxed);
+        _tail.store(tail, std::memory_order_relaxed);
+        other._head.store(tail, std::memory_order_relaxed);
+        return *this;
+    }
+
+    // Producer
+    bool Push(const T& value)
+    {
+        u32 tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        _buffer[tail & MASK] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer
+    bool Peek(T& value) const
+    {
+        u32 head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire))
+            return false;
+
+        value = _buffer[head & MASK];
+        return true;
+    }
+    void Pop()
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    bool TryPop(T& value)
+    {
+        if (!Peek(value))
+            return false;
+
+        Pop();
+        return true;
+    }
+
+    bool IsEmpty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+    u32 Size() const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire); }
+    static constexpr u32 GetCapacity() { return Capacity; }
+
+private:
+    static constexpr u32 MASK = Capacity - 1;
+
+    std::atomic<u32> _head; // Owned by the consumer
+    std::atomic<u32> _tail; // Owned by the producer
+    T _buffer[Capacity];
+};
@@ -1,14 +1,31 @@
 #include "ServiceLocator.h"
 #include "../Networking/MessageHandler.h"
+#include "../Networking/ConnectionIdentity.h"
+#include "../Database/AccountQueryService.h"
+#include "../Cryptography/CryptoWorkerPool.h"
+#include "../Database/SessionKeyStore.h"
+#include "../Networking/RealmRegistry.h"
+#include "../Networking/RateLimiter.h"
+#include "PacketCapture.h"
 
-entt::registry* ServiceLocator::_mainRegistry = nullptr;
+entt::registry* ServiceLocator::_registries[MAX_ENGINE_SHARDS] = {};
 MessageHandler* ServiceLocator::_clientMessageHandler = nullptr;
 MessageHandler* ServiceLocator::_internalMessageHandler = nullptr;
+AccountQueryService* ServiceLocator::_accountQueryService = nullptr;
+CryptoWorkerPool* ServiceLocator::_cryptoWorkerPool = nullptr;
+SessionKeyStore* ServiceLocator::_sessionKeyStore = nullptr;
+RealmRegistry* ServiceLocator::_realmRegistry = nullptr;
+AccountRateLimiter* ServiceLocator::_accountRateLimiter = nullptr;
+PacketCaptureWriter* ServiceLocator::_packetCaptureWriter = nullptr;
 
-void ServiceLocator::SetMainRegistry(entt::registry* registry)
+entt::registry* ServiceLocator::GetConnectionRegistry(u64 connectionIdentity)
 {
-    assert(_mainRegistry == nullptr);
-    _mainRegistry = registry;
+    return _registries[ConnectionIdentity::GetShardIndex(connectionIdentity)];
+}
+void ServiceLocator::SetRegistry(u32 shardIndex, entt::registry* registry)
+{
+    assert(shardIndex < MAX_ENGINE_SHARDS && _registries[shardIndex] == nullptr);
+    _registries[shardIndex] = registry;
 }
 void ServiceLocator::SetClientMessageHandler(MessageHandler* clientMessageHandler)
 {
@@ -19,4 +36,50 @@ void ServiceLocator::SetInternalMessageHandler(MessageHandler* serverMessageHand
 {
     assert(_internalMessageHandler == nullptr);
     _internalMessageHandler = serverMessageHandler;
+}
+void ServiceLocator::SetAccountQueryService(AccountQueryService* accountQueryService)
+{
+    assert(_accountQueryService == nullptr);
+    _accountQueryService = accountQueryService;
+}
+void ServiceLocator::SetCryptoWorkerPool(CryptoWorkerPool* cryptoWorkerPool)
+{
+    assert(_cryptoWorkerPool == nullptr);
+    _cryptoWorkerPool = cryptoWorkerPool;
+}
+void ServiceLocator::SetSessionKeyStore(SessionKeyStore* sessionKeyStore)
+{
+    assert(_sessionKeyStore == nullptr);
+    _sessionKeyStore = sessionKeyStore;
+}
+void ServiceLocator::SetRealmRegistry(RealmRegistry* realmRegistry)
+{
+    assert(_realmRegistry == nullptr);
+    _realmRegistry = realmRegistry;
+}
+void ServiceLocator::SetAccountRateLimiter(AccountRateLimiter* accountRateLimiter)
+{
+    assert(_accountRateLimiter == nullptr);
+    _accountRateLimiter = accountRateLimiter;
+}
+void ServiceLocator::SetPacketCaptureWriter(PacketCaptureWriter* packetCaptureWriter)
+{
+    assert(_packetCaptureWriter == nullptr);
+    _packetCaptureWriter = packetCaptureWriter;
+}
+void ServiceLocator::Reset()
+{
+    for (entt::registry*& registry : _registries)
+    {
+        registry = nullptr;
+    }
+
+    _clientMessageHandler = nullptr;
+    _internalMessageHandler = nullptr;
+    _accountQueryService = nullptr;
+    _cryptoWorkerPool = nullptr;
+    _sessionKeyStore = nullptr;
+    _realmRegistry = nullptr;
+    _accountRateLimiter = nullptr;
+    _packetCaptureWriter = nullptr;
 }
\ No newline at end of file
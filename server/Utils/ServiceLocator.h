@@ -26,11 +26,21 @@
 #include <entt.hpp>
 
 class MessageHandler;
+class AccountQueryService;
+class CryptoWorkerPool;
+class SessionKeyStore;
+class RealmRegistry;
+class PacketCaptureWriter;
+class AccountRateLimiter;
 class ServiceLocator
 {
 public:
-    static entt::registry* GetMainRegistry() { return _mainRegistry; }
-    static void SetMainRegistry(entt::registry* registry);
+    static constexpr u32 MAX_ENGINE_SHARDS = 64;
+
+    // Every engine shard has its own registry, the shard a connection belongs to is part of its identity, see ConnectionIdentity
+    static entt::registry* GetRegistry(u32 shardIndex) { return _registries[shardIndex]; }
+    static entt::registry* GetConnectionRegistry(u64 connectionIdentity);
+    static void SetRegistry(u32 shardIndex, entt::registry* registry);
 
     static MessageHandler* GetClientMessageHandler() { return _clientMessageHandler; }
     static void SetClientMessageHandler(MessageHandler* clientMessageHandler);
@@ -38,8 +48,35 @@ public:
     static MessageHandler* GetInternalMessageHandler() { return _internalMessageHandler; }
     static void SetInternalMessageHandler(MessageHandler* serverMessageHandler);
 
+    static AccountQueryService* GetAccountQueryService() { return _accountQueryService; }
+    static void SetAccountQueryService(AccountQueryService* accountQueryService);
+
+    static CryptoWorkerPool* GetCryptoWorkerPool() { return _cryptoWorkerPool; }
+    static void SetCryptoWorkerPool(CryptoWorkerPool* cryptoWorkerPool);
+
+    static SessionKeyStore* GetSessionKeyStore() { return _sessionKeyStore; }
+    static void SetSessionKeyStore(SessionKeyStore* sessionKeyStore);
+
+    static RealmRegistry* GetRealmRegistry() { return _realmRegistry; }
+    static void SetRealmRegistry(RealmRegistry* realmRegistry);
+
+    static AccountRateLimiter* GetAccountRateLimiter() { return _accountRateLimiter; }
+    static void SetAccountRateLimiter(AccountRateLimiter* accountRateLimiter);
+
+    static PacketCaptureWriter* GetPacketCaptureWriter() { return _packetCaptureWriter; }
+    static void SetPacketCaptureWriter(PacketCaptureWriter* packetCaptureWriter);
+
+    // Forgets every registry and service, called by the EngineLoopGroup that set them when it goes away
+    static void Reset();
+
 private:
-    static entt::registry* _mainRegistry;
+    static entt::registry* _registries[MAX_ENGINE_SHARDS];
     static MessageHandler* _clientMessageHandler;
     static MessageHandler* _internalMessageHandler;
+    static AccountQueryService* _accountQueryService;
+    static CryptoWorkerPool* _cryptoWorkerPool;
+    static SessionKeyStore* _sessionKeyStore;
+    static RealmRegistry* _realmRegistry;
+    static AccountRateLimiter* _accountRateLimiter;
+    static PacketCaptureWriter* _packetCaptureWriter;
 };
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(u64 resolutionNS) : _resolutionNS(resolutionNS), _currentTick(0), _activeCount(0), _freeList(INVALID_INDEX)
+{
+    for (u32& slot : _slots)
+    {
+        slot = INVALID_INDEX;
+    }
+}
+
+TimerHandle TimerWheel::Schedule(u64 expireAtNS, u32 type, u64 data)
+{
+    u32 nodeIndex = _freeList;
+    if (nodeIndex != INVALID_INDEX)
+    {
+        _freeList = _nodes[nodeIndex].next;
+    }
+    else
+    {
+        nodeIndex = static_cast<u32>(_nodes.size());
+        _nodes.emplace_back();
+    }
+
+    // Round up so a timer never fires early, anything already due fires on the next Advance
+    u64 expireTick = (expireAtNS + _resolutionNS - 1) / _resolutionNS;
+
+    Node& node = _nodes[nodeIndex];
+    node.expireTick = expireTick > _currentTick ? expireTick : _currentTick + 1;
+    node.type = type;
+    node.data = data;
+    Insert(nodeIndex);
+
+    _activeCount++;
+    return (static_cast<u64>(node.generation) << 32) | (nodeIndex + 1);
+}
+
+bool TimerWheel::Cancel(TimerHandle handle)
+{
+    if (!IsActive(handle))
+        return false;
+
+    u32 nodeIndex = static_cast<u32>(handle & 0xFFFFFFFF) - 1;
+    Unlink(nodeIndex);
+    Free(nodeIndex);
+    return true;
+}
+
+bool TimerWheel::IsActive(TimerHandle handle) const
+{
+    u32 nodeIndex = static_cast<u32>(handle & 0xFFFFFFFF) - 1;
+    if (handle == 0 || nodeIndex >= _nodes.size())
+        return false;
+
+    const Node& node = _nodes[nodeIndex];
+    return node.generation == static_cast<u32>(handle >> 32) && node.slot != INVALID_INDEX;
+}
+
+void TimerWheel::Advance(u64 nowNS, std::vector<ExpiredTimer>& expiredTimers)
+{
+    u64 nowTick = nowNS / _resolutionNS;
+
+    // Nothing can fire, skip straight ahead instead of stepping through the idle ticks
+    if (_activeCount == 0)
+    {
+        _currentTick = nowTick > _currentTick ? nowTick : _currentTick;
+        return;
+    }
+
+    while (_currentTick < nowTick)
+    {
+        _currentTick++;
+
+        // Every time a level wraps around the next slot of the level above is due to be spread over the levels below
+        for (u32 level = 1; level < LEVEL_COUNT; level++)
+        {
+            if ((_currentTick >> ((level - 1) * SLOT_BITS)) & (SLOT_COUNT - 1))
+                break;
+
+            Cascade(level);
+        }
+
+        u32& slot = _slots[_currentTick & (SLOT_COUNT - 1)];
+        while (slot != INVALID_INDEX)
+        {
+            u32 nodeIndex = slot;
+            Node& node = _nodes[nodeIndex];
+
+            ExpiredTimer expiredTimer;
+            expiredTimer.type = node.type;
+            expiredTimer.data = node.data;
+            expiredTimers.push_back(expiredTimer);
+
+            Unlink(nodeIndex);
+            Free(nodeIndex);
+        }
+
+        if (_activeCount == 0)
+        {
+            _currentTick = nowTick;
+            break;
+        }
+    }
+}
+
+void TimerWheel::Insert(u32 nodeIndex)
+{
+    Node& node = _nodes[nodeIndex];
+    u64 delta = node.expireTick - _currentTick;
+
+    u32 level = 0;
+    while (level < LEVEL_COUNT - 1 && delta >= (1ull << ((level + 1) * SLOT_BITS)))
+    {
+        level++;
+    }
+
+    // Past the range of the top level, park it in its furthest slot and let it cascade down from there
+    u64 tick = node.expireTick;
+    u64 maxDelta = (1ull << (LEVEL_COUNT * SLOT_BITS)) - 1;
+    if (delta > maxDelta)
+        tick = _currentTick + maxDelta;
+
+    u32 slot = level * SLOT_COUNT + static_cast<u32>((tick >> (level * SLOT_BITS)) & (SLOT_COUNT - 1));
+
+    node.slot = slot;
+    node.previous = INVALID_INDEX;
+    node.next = _slots[slot];
+    if (node.next != INVALID_INDEX)
+        _nodes[node.next].previous = nodeIndex;
+
+    _slots[slot] = nodeIndex;
+}
+
+void TimerWheel::Unlink(u32 nodeIndex)
+{
+    Node& node = _nodes[nodeIndex];
+
+    if (node.previous != INVALID_INDEX)
+        _nodes[node.previous].next = node.next;
+    else
+        _slots[node.slot] = node.next;
+
+    if (node.next != INVALID_INDEX)
+        _nodes[node.next].previous = node.previous;
+
+    node.slot = INVALID_INDEX;
+    node.previous = INVALID_INDEX;
+    node.next = INVALID_INDEX;
+}
+
+void TimerWheel::Free(u32 nodeIndex)
+{
+    Node& node = _nodes[nodeIndex];
+    node.generation++;
+    node.next = _freeList;
+    _freeList = nodeIndex;
+    _activeCount--;
+}
+
+void TimerWheel::Cascade(u32 level)
+{
+    u32 slot = level * SLOT_COUNT + static_cast<u32>((_currentTick >> (level * SLOT_BITS)) & (SLOT_COUNT - 1));
+
+    u32 nodeIndex = _slots[slot];
+    _slots[slot] = INVALID_INDEX;
+
+    while (nodeIndex != INVALID_INDEX)
+    {
+        u32 next = _nodes[nodeIndex].next;
+        Insert(nodeIndex);
+        nodeIndex = next;
+    }
+}
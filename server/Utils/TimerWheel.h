@@ -0,0 +1,85 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <vector>
+
+typedef u64 TimerHandle; // 0 is never a valid handle
+
+struct ExpiredTimer
+{
+    u32 type;
+    u64 data;
+};
+
+// Hierarchical timer wheel, LEVEL_COUNT wheels of SLOT_COUNT slots where every level is SLOT_COUNT times coarser than the one below.
+// Schedule and Cancel are O(1), Advance only touches the slots that are due and cascades a coarser slot down once per revolution.
+// Timers are nodes in a pool and every handle carries a generation, cancelling a timer that already fired is harmless.
+// Times are in nanoseconds on whatever clock the caller advances it with. Not thread safe.
+class TimerWheel
+{
+public:
+    static constexpr u32 SLOT_BITS = 8;
+    static constexpr u32 SLOT_COUNT = 1 << SLOT_BITS;
+    static constexpr u32 LEVEL_COUNT = 4;
+
+    TimerWheel(u64 resolutionNS);
+
+    TimerHandle Schedule(u64 expireAtNS, u32 type, u64 data);
+    bool Cancel(TimerHandle handle);
+    bool IsActive(TimerHandle handle) const;
+
+    // Fires every timer due at nowNS in the order they expire
+    void Advance(u64 nowNS, std::vector<ExpiredTimer>& expiredTimers);
+
+    u32 GetActiveCount() const { return _activeCount; }
+
+private:
+    static constexpr u32 INVALID_INDEX = 0xFFFFFFFF;
+
+    struct Node
+    {
+        u64 expireTick = 0;
+        u64 data = 0;
+        u32 type = 0;
+        u32 generation = 0;
+        u32 previous = INVALID_INDEX;
+        u32 next = INVALID_INDEX; // Also links the free list
+        u32 slot = INVALID_INDEX; // Index into _slots while scheduled
+    };
+
+    void Insert(u32 nodeIndex);
+    void Unlink(u32 nodeIndex);
+    void Free(u32 nodeIndex);
+    void Cascade(u32 level);
+
+private:
+    u64 _resolutionNS;
+    u64 _currentTick;
+    u32 _activeCount;
+
+    std::vector<Node> _nodes;
+    u32 _freeList;
+    u32 _slots[LEVEL_COUNT * SLOT_COUNT];
+};
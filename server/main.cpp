@@ -6,8 +6,10 @@
 #include <Networking/BaseServer.h>
 
 #include <future>
+#include <thread>
 
-#include "EngineLoop.h"
+#include "EngineLoopGroup.h"
+#include "Utils/AsyncLogger.h"
 #include "ConsoleCommands.h"
 
 #ifdef _WIN32
@@ -19,27 +21,31 @@ i32 main()
 #ifdef _WIN32 //Windows
     SetConsoleTitle(WINDOWNAME);
 #endif
-    EngineLoop engineLoop(30);
-    engineLoop.Start();
+    AsyncLogger::Start();
+
+    // Every shard runs its own engine thread and taskflow workers, a few cores each keeps the systems parallel within a shard
+    u32 shardCount = std::max(std::thread::hardware_concurrency() / 4, 1u);
+    EngineLoopGroup engineLoopGroup(shardCount, 30, EngineLoopMode::EVENT_DRIVEN);
+    engineLoopGroup.SetAccountsFile("accounts.txt");
+    engineLoopGroup.Start();
 
     ConsoleCommandHandler consoleCommandHandler;
     std::future<std::string> future = std::async(std::launch::async, StringUtils::GetLineFromCin);
     while (true)
     {
-        Message message;
+        EngineOutputMessage message;
         bool shouldExit = false;
 
-        while (engineLoop.TryGetMessage(message))
+        while (engineLoopGroup.TryGetMessage(message))
         {
-            if (message.code == MSG_OUT_EXIT_CONFIRM)
+            if (message.type == EngineOutputType::EXIT_CONFIRM)
             {
                 shouldExit = true;
                 break;
             }
-            else if (message.code == MSG_OUT_PRINT)
+            else if (message.type == EngineOutputType::PRINT)
             {
-                NC_LOG_MESSAGE(*message.message);
-                delete message.message;
+                NC_LOG_MESSAGE(std::string(message.text));
             }
         }
 
@@ -51,11 +57,12 @@ i32 main()
             std::string command = future.get();
             std::transform(command.begin(), command.end(), command.begin(), ::tolower); // Convert command to lowercase
 
-            consoleCommandHandler.HandleCommand(engineLoop, command);
+            consoleCommandHandler.HandleCommand(engineLoopGroup, command);
             future = std::async(std::launch::async, StringUtils::GetLineFromCin);
         }
     }
 
-    engineLoop.Stop();
+    engineLoopGroup.Stop();
+    AsyncLogger::Stop();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "Test.h"
+#include "Networking/RateLimiter.h"
+
+// The transitions a key goes through, from allowed to limited to banned and back once the ban runs out
+
+namespace
+{
+    constexpr u64 SECOND_NS = 1000000000ull;
+
+    void TestBanAfterStrikes()
+    {
+        TokenBucketTable buckets(64, { 3.0f, 1.0f, 2, 10 * SECOND_NS });
+
+        // A new bucket starts full
+        TEST_CHECK(buckets.Consume(42, 0) == RateLimitResult::ALLOWED);
+        TEST_CHECK(buckets.Consume(42, 0) == RateLimitResult::ALLOWED);
+        TEST_CHECK(buckets.Consume(42, 0) == RateLimitResult::ALLOWED);
+        TEST_CHECK(!buckets.IsBanned(42, 0));
+
+        // Empty, the first rejection is a strike and the second one bans
+        TEST_CHECK(buckets.Consume(42, 0) == RateLimitResult::LIMITED);
+        TEST_CHECK(!buckets.IsBanned(42, 0));
+        TEST_CHECK(buckets.Consume(42, 0) == RateLimitResult::BANNED);
+        TEST_CHECK(buckets.IsBanned(42, 0));
+
+        // Refilling doesn't lift the ban, only the ban running out does
+        TEST_CHECK(buckets.Consume(42, 5 * SECOND_NS) == RateLimitResult::BANNED);
+        TEST_CHECK(buckets.IsBanned(42, 10 * SECOND_NS - 1));
+        TEST_CHECK(!buckets.IsBanned(42, 10 * SECOND_NS));
+        TEST_CHECK(buckets.Consume(42, 10 * SECOND_NS) == RateLimitResult::ALLOWED);
+
+        // Other keys were never affected
+        TEST_CHECK(buckets.Consume(43, 0) == RateLimitResult::ALLOWED);
+        TEST_CHECK(!buckets.IsBanned(43, 0));
+    }
+
+    void TestRefill()
+    {
+        TokenBucketTable buckets(64, { 2.0f, 2.0f, 0, 0 });
+
+        TEST_CHECK(buckets.Consume(7, 0) == RateLimitResult::ALLOWED);
+        TEST_CHECK(buckets.Consume(7, 0) == RateLimitResult::ALLOWED);
+        TEST_CHECK(buckets.Consume(7, 0) == RateLimitResult::LIMITED);
+
+        // 0.6 seconds at 2 per second is one token and a bit
+        TEST_CHECK(buckets.Consume(7, 600000000ull) == RateLimitResult::ALLOWED);
+        TEST_CHECK(buckets.Consume(7, 600000000ull) == RateLimitResult::LIMITED);
+
+        // Never more than the burst, however long the bucket sat idle
+        u64 later = 3600 * SECOND_NS;
+        TEST_CHECK(buckets.Consume(7, later) == RateLimitResult::ALLOWED);
+        TEST_CHECK(buckets.Consume(7, later) == RateLimitResult::ALLOWED);
+        TEST_CHECK(buckets.Consume(7, later) == RateLimitResult::LIMITED);
+
+        // Without strikesBeforeBan it's limited forever but never banned
+        for (u32 i = 0; i < 1000; i++)
+        {
+            TEST_CHECK(buckets.Consume(7, later) == RateLimitResult::LIMITED);
+        }
+        TEST_CHECK(!buckets.IsBanned(7, later));
+    }
+
+    void TestStrikesReset()
+    {
+        TokenBucketTable buckets(64, { 1.0f, 1.0f, 3, 10 * SECOND_NS });
+
+        TEST_CHECK(buckets.Consume(9, 0) == RateLimitResult::ALLOWED);
+        TEST_CHECK(buckets.Consume(9, 0) == RateLimitResult::LIMITED);
+        TEST_CHECK(buckets.Consume(9, 0) == RateLimitResult::LIMITED);
+
+        // An allowed packet in between starts the count over, the strikes have to be in a row
+        TEST_CHECK(buckets.Consume(9, SECOND_NS) == RateLimitResult::ALLOWED);
+        TEST_CHECK(buckets.Consume(9, SECOND_NS) == RateLimitResult::LIMITED);
+        TEST_CHECK(buckets.Consume(9, SECOND_NS) == RateLimitResult::LIMITED);
+        TEST_CHECK(buckets.Consume(9, SECOND_NS) == RateLimitResult::BANNED);
+    }
+
+    void TestBan()
+    {
+        TokenBucketTable buckets(64, { 5.0f, 1.0f, 0, 0 });
+
+        // An explicit ban claims a bucket for a key that was never seen
+        buckets.Ban(11, 0, 30 * SECOND_NS);
+        TEST_CHECK(buckets.IsBanned(11, 0));
+        TEST_CHECK(buckets.Consume(11, 0) == RateLimitResult::BANNED);
+
+        // A shorter ban doesn't cut a longer one short
+        buckets.Ban(11, 0, SECOND_NS);
+        TEST_CHECK(buckets.IsBanned(11, 20 * SECOND_NS));
+        TEST_CHECK(!buckets.IsBanned(11, 30 * SECOND_NS));
+
+        // Key 0 marks an empty slot, it's tracked as key 1
+        buckets.Ban(0, 0, SECOND_NS);
+        TEST_CHECK(buckets.IsBanned(0, 0));
+        TEST_CHECK(buckets.IsBanned(1, 0));
+    }
+
+    void TestBansSurviveRecycling()
+    {
+        // The smallest table, a single probe window. Keys are their own hash, so every key below competes for the same slots
+        TokenBucketTable buckets(1, { 1.0f, 1.0f, 0, 0 });
+
+        buckets.Ban(16, 0, 1000 * SECOND_NS);
+        TEST_CHECK(buckets.Consume(1, 0) == RateLimitResult::ALLOWED);
+
+        // Asking about keys that have no bucket doesn't claim one, key 1 keeps its empty bucket
+        for (u64 key = 100; key < 200; key++)
+        {
+            TEST_CHECK(!buckets.IsBanned(key, 0));
+        }
+        TEST_CHECK(buckets.Consume(1, 0) == RateLimitResult::LIMITED);
+
+        // Far more keys than slots, the stalest buckets are recycled but never the banned one
+        for (u64 key = 1000; key < 5000; key++)
+        {
+            buckets.Consume(key, key * 1000);
+        }
+        TEST_CHECK(buckets.IsBanned(16, 10 * SECOND_NS));
+
+        // With every slot banned there is nothing left to track a new key with, it's let through
+        for (u64 key = 2; key < 16; key++)
+        {
+            buckets.Ban(key, 10 * SECOND_NS, 1000 * SECOND_NS);
+        }
+        buckets.Ban(1, 10 * SECOND_NS, 1000 * SECOND_NS);
+        TEST_CHECK(buckets.IsBanned(16, 10 * SECOND_NS));
+        for (u32 i = 0; i < 3; i++)
+        {
+            TEST_CHECK(buckets.Consume(12345, 10 * SECOND_NS) == RateLimitResult::ALLOWED);
+        }
+    }
+
+    void TestAccountRateLimiter()
+    {
+        // The default config, five failed logins and the account is banned for five minutes
+        AccountRateLimiter accountRateLimiter;
+        u64 now = 1000 * SECOND_NS;
+
+        for (u32 i = 0; i < 5; i++)
+        {
+            TEST_CHECK(!accountRateLimiter.IsAccountBanned("alice", now));
+            TEST_CHECK(accountRateLimiter.RecordFailedLogin("alice", now) == RateLimitResult::ALLOWED);
+        }
+        TEST_CHECK(accountRateLimiter.RecordFailedLogin("alice", now) == RateLimitResult::BANNED);
+        TEST_CHECK(accountRateLimiter.IsAccountBanned("alice", now));
+        TEST_CHECK(accountRateLimiter.RecordFailedLogin("alice", now + SECOND_NS) == RateLimitResult::BANNED);
+
+        TEST_CHECK(!accountRateLimiter.IsAccountBanned("bob", now));
+        TEST_CHECK(accountRateLimiter.RecordFailedLogin("bob", now) == RateLimitResult::ALLOWED);
+
+        TEST_CHECK(accountRateLimiter.IsAccountBanned("alice", now + 300 * SECOND_NS - 1));
+        TEST_CHECK(!accountRateLimiter.IsAccountBanned("alice", now + 300 * SECOND_NS));
+
+        accountRateLimiter.BanAccount("carol", now, 60 * SECOND_NS);
+        TEST_CHECK(accountRateLimiter.IsAccountBanned("carol", now));
+        TEST_CHECK(!accountRateLimiter.IsAccountBanned("carol", now + 60 * SECOND_NS));
+    }
+}
+
+int main()
+{
+    TestBanAfterStrikes();
+    TestRefill();
+    TestStrikesReset();
+    TestBan();
+    TestBansSurviveRecycling();
+    TestAccountRateLimiter();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,154 @@
+#include "Test.h"
+#include "Cryptography/SHA256.h"
+#include "Cryptography/SHA256MultiBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The SIMD kernels against the scalar SHA256, and the scalar SHA256 against the FIPS 180-2 test vectors.
+// Every kernel the CPU supports is forced through SHA256MultiBuffer::SetMaxLaneCount, kernels it doesn't support are skipped.
+
+namespace
+{
+    std::string ToHex(const u8* data, size_t size)
+    {
+        static const char digits[] = "0123456789abcdef";
+
+        std::string hex;
+        for (size_t i = 0; i < size; i++)
+        {
+            hex += digits[data[i] >> 4];
+            hex += digits[data[i] & 15];
+        }
+
+        return hex;
+    }
+
+    struct KnownAnswer
+    {
+        std::string message;
+        const char* digest;
+    };
+
+    std::vector<KnownAnswer> GetKnownAnswers()
+    {
+        return
+        {
+            { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+            { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+            { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+            { "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+              "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+            { std::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" }
+        };
+    }
+
+    void TestScalarKnownAnswers()
+    {
+        for (const KnownAnswer& knownAnswer : GetKnownAnswers())
+        {
+            u8 digest[SHA256::DIGEST_SIZE];
+            SHA256::Hash(knownAnswer.message.data(), knownAnswer.message.size(), digest);
+            TEST_CHECK_MESSAGE(ToHex(digest, sizeof(digest)) == knownAnswer.digest, "message of %zu bytes", knownAnswer.message.size());
+
+            // Fed in uneven pieces, so Update has to carry partial blocks over
+            SHA256 sha256;
+            for (size_t offset = 0; offset < knownAnswer.message.size(); offset += 37)
+            {
+                sha256.Update(knownAnswer.message.data() + offset, std::min<size_t>(37, knownAnswer.message.size() - offset));
+            }
+
+            u8 updatedDigest[SHA256::DIGEST_SIZE];
+            sha256.Final(updatedDigest);
+            TEST_CHECK_MESSAGE(ToHex(updatedDigest, sizeof(updatedDigest)) == knownAnswer.digest, "message of %zu bytes fed in pieces", knownAnswer.message.size());
+        }
+    }
+
+    void TestKernel(u32 laneCount)
+    {
+        SHA256MultiBuffer::SetMaxLaneCount(laneCount);
+        if (SHA256MultiBuffer::GetLaneCount() != laneCount)
+        {
+            std::printf("Skipped the %u lane kernel, this CPU or build doesn't have it\n", laneCount);
+            return;
+        }
+
+        const char* kernelName = SHA256MultiBuffer::GetKernelName();
+
+        // A full set of lanes of every known answer message but the long one
+        std::vector<KnownAnswer> knownAnswers = GetKnownAnswers();
+        knownAnswers.pop_back();
+
+        std::vector<SHA256BatchEntry> entries;
+        std::vector<std::string> expectedDigests;
+        for (const KnownAnswer& knownAnswer : knownAnswers)
+        {
+            for (u32 lane = 0; lane < laneCount; lane++)
+            {
+                SHA256BatchEntry entry;
+                entry.data = knownAnswer.message.data();
+                entry.size = knownAnswer.message.size();
+                entries.push_back(entry);
+                expectedDigests.push_back(knownAnswer.digest);
+            }
+        }
+
+        // Every size up to four blocks, so messages end before, at and after the padding boundaries of every block.
+        // A few more copies of each size than the kernel has lanes, the rest falls through to the narrower kernels
+        constexpr size_t MAX_MESSAGE_SIZE = 4 * SHA256::BLOCK_SIZE;
+        u32 copyCount = laneCount + 3;
+
+        std::vector<std::vector<u8>> messages;
+        messages.reserve((MAX_MESSAGE_SIZE + 1) * copyCount);
+        for (size_t size = 0; size <= MAX_MESSAGE_SIZE; size++)
+        {
+            for (u32 copy = 0; copy < copyCount; copy++)
+            {
+                std::vector<u8> message(size);
+                for (size_t i = 0; i < size; i++)
+                {
+                    message[i] = static_cast<u8>(size * 31 + copy * 7 + i * 13);
+                }
+
+                u8 digest[SHA256::DIGEST_SIZE];
+                SHA256::Hash(message.data(), message.size(), digest);
+                expectedDigests.push_back(ToHex(digest, sizeof(digest)));
+                messages.push_back(std::move(message));
+
+                SHA256BatchEntry entry;
+                entry.data = messages.back().data();
+                entry.size = messages.back().size();
+                entries.push_back(entry);
+            }
+        }
+
+        std::vector<u8> digests(entries.size() * SHA256::DIGEST_SIZE);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            entries[i].digest = &digests[i * SHA256::DIGEST_SIZE];
+        }
+
+        SHA256MultiBuffer::HashBatch(entries.data(), entries.size());
+
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            std::string digest = ToHex(entries[i].digest, SHA256::DIGEST_SIZE);
+            TEST_CHECK_MESSAGE(digest == expectedDigests[i], "%s kernel, message %zu of %zu bytes", kernelName, i, entries[i].size);
+        }
+
+        std::printf("Checked the %s kernel against %zu messages\n", kernelName, entries.size());
+    }
+}
+
+int main()
+{
+    TestScalarKnownAnswers();
+
+    for (u32 laneCount : { 16u, 8u, 4u, 1u })
+    {
+        TestKernel(laneCount);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,152 @@
+#include "Test.h"
+#include "Utils/SPSCRingBuffer.h"
+#include <string>
+#include <thread>
+
+namespace
+{
+    void TestFullAndEmpty()
+    {
+        SPSCRingBuffer<u32, 4> ringBuffer;
+        u32 value = 0;
+
+        TEST_CHECK(ringBuffer.IsEmpty());
+        TEST_CHECK(ringBuffer.Size() == 0);
+        TEST_CHECK(!ringBuffer.Peek(value));
+        TEST_CHECK(!ringBuffer.TryPop(value));
+
+        for (u32 i = 0; i < 4; i++)
+        {
+            TEST_CHECK(ringBuffer.Push(i));
+        }
+        TEST_CHECK(!ringBuffer.Push(4));
+        TEST_CHECK(ringBuffer.Size() == 4);
+
+        // Peek leaves the value in place until Pop
+        TEST_CHECK(ringBuffer.Peek(value) && value == 0);
+        TEST_CHECK(ringBuffer.Peek(value) && value == 0);
+        ringBuffer.Pop();
+        TEST_CHECK(ringBuffer.Size() == 3);
+        TEST_CHECK(ringBuffer.Push(4));
+
+        for (u32 i = 1; i <= 4; i++)
+        {
+            TEST_CHECK(ringBuffer.TryPop(value) && value == i);
+        }
+        TEST_CHECK(ringBuffer.IsEmpty());
+        TEST_CHECK(!ringBuffer.TryPop(value));
+    }
+
+    void TestWrapAround()
+    {
+        // Many times around a small buffer at every fill level, values come out in the order they went in
+        SPSCRingBuffer<u32, 8> ringBuffer;
+        u32 pushed = 0;
+        u32 popped = 0;
+
+        for (u32 round = 0; round < 1000; round++)
+        {
+            u32 pushCount = round % 9;
+            for (u32 i = 0; i < pushCount; i++)
+            {
+                if (ringBuffer.Push(pushed))
+                    pushed++;
+            }
+
+            u32 popCount = (round * 7) % 9;
+            u32 value = 0;
+            for (u32 i = 0; i < popCount && ringBuffer.TryPop(value); i++)
+            {
+                TEST_CHECK_MESSAGE(value == popped, "popped %u, expected %u", value, popped);
+                popped++;
+            }
+
+            TEST_CHECK(ringBuffer.Size() == pushed - popped);
+            TEST_CHECK(ringBuffer.Size() <= ringBuffer.GetCapacity());
+        }
+    }
+
+    void TestMove()
+    {
+        SPSCRingBuffer<std::string, 4> ringBuffer;
+        std::string value;
+
+        // Wrapped around once, so the contents don't start at the front of the storage
+        ringBuffer.Push("first");
+        ringBuffer.Push("second");
+        ringBuffer.TryPop(value);
+        ringBuffer.TryPop(value);
+        ringBuffer.Push("a");
+        ringBuffer.Push("b");
+        ringBuffer.Push("c");
+
+        SPSCRingBuffer<std::string, 4> moved(std::move(ringBuffer));
+        TEST_CHECK(ringBuffer.IsEmpty());
+        TEST_CHECK(moved.Size() == 3);
+
+        SPSCRingBuffer<std::string, 4> assigned;
+        assigned.Push("replaced");
+        assigned = std::move(moved);
+        TEST_CHECK(moved.IsEmpty());
+        TEST_CHECK(assigned.Size() == 3);
+
+        TEST_CHECK(assigned.TryPop(value) && value == "a");
+        TEST_CHECK(assigned.TryPop(value) && value == "b");
+        TEST_CHECK(assigned.TryPop(value) && value == "c");
+        TEST_CHECK(!assigned.TryPop(value));
+
+        // Still usable afterwards
+        TEST_CHECK(ringBuffer.Push("d"));
+        TEST_CHECK(ringBuffer.TryPop(value) && value == "d");
+    }
+
+    void TestProducerConsumer()
+    {
+        // One producer and one consumer thread, every value arrives exactly once and in order
+        constexpr u64 VALUE_COUNT = 1000000;
+        static SPSCRingBuffer<u64, 64> ringBuffer;
+
+        std::thread producer([]()
+        {
+            for (u64 i = 1; i <= VALUE_COUNT; i++)
+            {
+                while (!ringBuffer.Push(i))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        u64 expected = 1;
+        u64 outOfOrderCount = 0;
+        while (expected <= VALUE_COUNT)
+        {
+            u64 value = 0;
+            if (!ringBuffer.TryPop(value))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (value != expected)
+                outOfOrderCount++;
+
+            expected = value + 1;
+        }
+
+        producer.join();
+
+        TEST_CHECK(outOfOrderCount == 0);
+        TEST_CHECK(ringBuffer.IsEmpty());
+    }
+}
+
+int main()
+{
+    TestFullAndEmpty();
+    TestWrapAround();
+    TestMove();
+    TestProducerConsumer();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,157 @@
+#include "Test.h"
+#include "Database/SessionKeyStore.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    SessionKey MakeKey(u8 seed)
+    {
+        SessionKey sessionKey;
+        for (size_t i = 0; i < sessionKey.size(); i++)
+        {
+            sessionKey[i] = static_cast<u8>(seed + i);
+        }
+
+        return sessionKey;
+    }
+
+    void TestInsertAndFind()
+    {
+        SessionKeyStore sessionKeyStore(1024);
+        SessionKey sessionKey;
+
+        TEST_CHECK(!sessionKeyStore.Find(1, 0, sessionKey));
+
+        sessionKeyStore.Insert(1, MakeKey(10), 1000, 0);
+        TEST_CHECK(sessionKeyStore.Find(1, 0, sessionKey) && sessionKey == MakeKey(10));
+        TEST_CHECK(sessionKeyStore.Validate(1, MakeKey(10), 0));
+        TEST_CHECK(!sessionKeyStore.Validate(1, MakeKey(11), 0));
+        TEST_CHECK(!sessionKeyStore.Validate(2, MakeKey(10), 0));
+
+        // Expired at expiresAtNS, it reads as missing from then on
+        TEST_CHECK(sessionKeyStore.Validate(1, MakeKey(10), 999));
+        TEST_CHECK(!sessionKeyStore.Validate(1, MakeKey(10), 1000));
+        TEST_CHECK(!sessionKeyStore.Find(1, 1000, sessionKey));
+
+        // A new login replaces the key
+        sessionKeyStore.Insert(1, MakeKey(20), 2000, 1000);
+        TEST_CHECK(sessionKeyStore.Validate(1, MakeKey(20), 1000));
+        TEST_CHECK(!sessionKeyStore.Validate(1, MakeKey(10), 1000));
+
+        // Account id 0 is never stored
+        sessionKeyStore.Insert(0, MakeKey(30), 2000, 1000);
+        TEST_CHECK(!sessionKeyStore.Find(0, 1000, sessionKey));
+    }
+
+    void TestRemoveIfMatches()
+    {
+        SessionKeyStore sessionKeyStore(1024);
+
+        sessionKeyStore.Insert(5, MakeKey(1), 1000, 0);
+        sessionKeyStore.Insert(5, MakeKey(2), 1000, 0);
+
+        // The connection of the older login going away doesn't revoke the newer key
+        TEST_CHECK(!sessionKeyStore.RemoveIfMatches(5, MakeKey(1)));
+        TEST_CHECK(sessionKeyStore.Validate(5, MakeKey(2), 0));
+
+        TEST_CHECK(sessionKeyStore.RemoveIfMatches(5, MakeKey(2)));
+        TEST_CHECK(!sessionKeyStore.Validate(5, MakeKey(2), 0));
+        TEST_CHECK(!sessionKeyStore.RemoveIfMatches(5, MakeKey(2)));
+        TEST_CHECK(!sessionKeyStore.RemoveIfMatches(6, MakeKey(2)));
+
+        // The account can log in again afterwards
+        sessionKeyStore.Insert(5, MakeKey(3), 1000, 0);
+        TEST_CHECK(sessionKeyStore.Validate(5, MakeKey(3), 0));
+    }
+
+    void TestFullTable()
+    {
+        // The smallest store, 16 shards of a single probe window each, so accounts collide all the time
+        SessionKeyStore sessionKeyStore(1);
+        TEST_CHECK(sessionKeyStore.GetCapacity() == SessionKeyStore::SHARD_COUNT * SessionKeyStore::MAX_PROBE_LENGTH);
+
+        // Removing accounts doesn't hide the ones stored behind them in the same probe window
+        for (u32 accountId = 1; accountId <= 128; accountId++)
+        {
+            sessionKeyStore.Insert(accountId, MakeKey(static_cast<u8>(accountId)), 1000, 0);
+        }
+        for (u32 accountId = 1; accountId <= 128; accountId += 2)
+        {
+            TEST_CHECK(sessionKeyStore.RemoveIfMatches(accountId, MakeKey(static_cast<u8>(accountId))));
+        }
+        for (u32 accountId = 2; accountId <= 128; accountId += 2)
+        {
+            TEST_CHECK_MESSAGE(sessionKeyStore.Validate(accountId, MakeKey(static_cast<u8>(accountId)), 0), "account %u", accountId);
+        }
+
+        // Far more logins than slots, each insert evicts the entry closest to expiring, so the one that expires last stays
+        sessionKeyStore.Insert(100000, MakeKey(99), ~0ull, 0);
+        for (u32 accountId = 1000; accountId < 11000; accountId++)
+        {
+            sessionKeyStore.Insert(accountId, MakeKey(static_cast<u8>(accountId)), 2000 + accountId, 0);
+            TEST_CHECK_MESSAGE(sessionKeyStore.Validate(accountId, MakeKey(static_cast<u8>(accountId)), 0), "account %u", accountId);
+        }
+        TEST_CHECK(sessionKeyStore.Validate(100000, MakeKey(99), 0));
+
+        u32 foundCount = 0;
+        for (u32 accountId = 1; accountId < 11000; accountId++)
+        {
+            SessionKey sessionKey;
+            if (sessionKeyStore.Find(accountId, 0, sessionKey))
+                foundCount++;
+        }
+        TEST_CHECK(foundCount < sessionKeyStore.GetCapacity());
+    }
+
+    void TestConcurrentReaders()
+    {
+        // A writer keeps replacing the key while readers look it up without locking, a reader must never see half of each key
+        SessionKeyStore sessionKeyStore(1024);
+        sessionKeyStore.Insert(7, MakeKey(0x10), ~0ull, 0);
+
+        std::atomic<bool> isWriting(true);
+        std::thread writer([&]()
+        {
+            for (u32 i = 0; i < 200000; i++)
+            {
+                sessionKeyStore.Insert(7, MakeKey(i & 1 ? 0x80 : 0x10), ~0ull, 0);
+            }
+            isWriting = false;
+        });
+
+        std::atomic<u32> tornCount(0);
+        std::vector<std::thread> readers;
+        for (u32 i = 0; i < 2; i++)
+        {
+            readers.emplace_back([&]()
+            {
+                SessionKey sessionKey;
+                while (isWriting)
+                {
+                    if (!sessionKeyStore.Find(7, 0, sessionKey) || (sessionKey != MakeKey(0x10) && sessionKey != MakeKey(0x80)))
+                        tornCount++;
+                }
+            });
+        }
+
+        writer.join();
+        for (std::thread& reader : readers)
+        {
+            reader.join();
+        }
+
+        TEST_CHECK(tornCount == 0);
+    }
+}
+
+int main()
+{
+    TestInsertAndFind();
+    TestRemoveIfMatches();
+    TestFullTable();
+    TestConcurrentReaders();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,193 @@
+#include "Test.h"
+#include "Utils/TimerWheel.h"
+#include <algorithm>
+#include <set>
+#include <vector>
+
+// Every timer has to fire exactly once, in the Advance that first reaches its deadline, no matter how many levels it
+// cascaded through on the way down. The wheel runs at a 1ns resolution in most tests so ticks and times are the same numbers.
+
+namespace
+{
+    // The same sequence on every run, so a failure can be reproduced
+    struct Random
+    {
+        u64 state = 0x9E3779B97F4A7C15;
+
+        u64 Next(u64 bound)
+        {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            return (state >> 33) % bound;
+        }
+    };
+
+    struct ScheduledTimer
+    {
+        u64 expireAt = 0;
+        u64 firedAt = 0;
+        u32 fireCount = 0;
+    };
+
+    void TestCascade()
+    {
+        TimerWheel timerWheel(1);
+        Random random;
+
+        std::vector<ScheduledTimer> timers;
+        std::multiset<u64> pendingExpireAts;
+        auto schedule = [&](u64 now, u64 expireAt)
+        {
+            ScheduledTimer timer;
+            timer.expireAt = expireAt > now ? expireAt : now + 1;
+            timers.push_back(timer);
+            pendingExpireAts.insert(timer.expireAt);
+            timerWheel.Schedule(expireAt, 0, timers.size() - 1);
+        };
+
+        // Deadlines on and around every level boundary, and spread over every level up to well into level 3
+        constexpr u64 levelRanges[] = { 1ull << 8, 1ull << 16, 1ull << 24 };
+        for (u64 levelRange : levelRanges)
+        {
+            for (u64 offset = 0; offset < 4; offset++)
+            {
+                schedule(0, levelRange - offset);
+                schedule(0, levelRange + offset);
+            }
+        }
+
+        for (u32 i = 0; i < 2000; i++)
+        {
+            schedule(0, 1 + random.Next(1ull << (8 + (i % 18))));
+        }
+
+        // Advance in uneven jumps and schedule more on the way, so timers are also inserted while the lower levels are mid revolution.
+        // A jump never passes the next deadline, it stops the tick before and then on it so a timer off by one can't slip through
+        std::vector<ExpiredTimer> expiredTimers;
+        u64 now = 0;
+        while (timerWheel.GetActiveCount() > 0)
+        {
+            u64 previousNow = now;
+            now += random.Next(8) == 0 ? 1 : 1 + random.Next(1 << 14);
+
+            u64 nextExpireAt = *pendingExpireAts.begin();
+            now = std::min(now, nextExpireAt - 1 > previousNow ? nextExpireAt - 1 : nextExpireAt);
+
+            if (timers.size() < 4000 && random.Next(4) == 0)
+                schedule(now, now + random.Next(1ull << 20));
+
+            expiredTimers.clear();
+            timerWheel.Advance(now, expiredTimers);
+
+            u64 previousExpireAt = 0;
+            for (const ExpiredTimer& expiredTimer : expiredTimers)
+            {
+                ScheduledTimer& timer = timers[expiredTimer.data];
+                timer.fireCount++;
+                pendingExpireAts.erase(pendingExpireAts.find(timer.expireAt));
+                timer.firedAt = now;
+
+                TEST_CHECK_MESSAGE(timer.expireAt > previousNow && timer.expireAt <= now, "timer %llu due at %llu fired by Advance(%llu) after Advance(%llu)",
+                    static_cast<unsigned long long>(expiredTimer.data), static_cast<unsigned long long>(timer.expireAt),
+                    static_cast<unsigned long long>(now), static_cast<unsigned long long>(previousNow));
+                TEST_CHECK_MESSAGE(timer.expireAt >= previousExpireAt, "timer %llu fired out of order", static_cast<unsigned long long>(expiredTimer.data));
+                previousExpireAt = timer.expireAt;
+            }
+        }
+
+        for (size_t i = 0; i < timers.size(); i++)
+        {
+            TEST_CHECK_MESSAGE(timers[i].fireCount == 1, "timer %zu due at %llu fired %u times", i, static_cast<unsigned long long>(timers[i].expireAt), timers[i].fireCount);
+        }
+    }
+
+    void TestResolution()
+    {
+        TimerWheel timerWheel(1000);
+        std::vector<ExpiredTimer> expiredTimers;
+
+        // Due within the second tick, it's rounded up to the end of that tick rather than firing early
+        timerWheel.Schedule(1500, 0, 0);
+        timerWheel.Advance(1999, expiredTimers);
+        TEST_CHECK(expiredTimers.empty());
+        timerWheel.Advance(2000, expiredTimers);
+        TEST_CHECK(expiredTimers.size() == 1);
+
+        // Already due, it fires on the next tick
+        expiredTimers.clear();
+        timerWheel.Schedule(0, 0, 0);
+        timerWheel.Advance(2999, expiredTimers);
+        TEST_CHECK(expiredTimers.empty());
+        timerWheel.Advance(3000, expiredTimers);
+        TEST_CHECK(expiredTimers.size() == 1);
+    }
+
+    void TestCancel()
+    {
+        TimerWheel timerWheel(1);
+        std::vector<ExpiredTimer> expiredTimers;
+
+        TimerHandle cancelled = timerWheel.Schedule(100, 1, 1);
+        TimerHandle kept = timerWheel.Schedule(70000, 2, 2);
+        TEST_CHECK(cancelled != 0 && kept != 0);
+        TEST_CHECK(timerWheel.IsActive(cancelled));
+
+        TEST_CHECK(timerWheel.Cancel(cancelled));
+        TEST_CHECK(!timerWheel.IsActive(cancelled));
+        TEST_CHECK(!timerWheel.Cancel(cancelled));
+        TEST_CHECK(timerWheel.GetActiveCount() == 1);
+
+        timerWheel.Advance(70000, expiredTimers);
+        TEST_CHECK(expiredTimers.size() == 1);
+        TEST_CHECK(expiredTimers.size() == 1 && expiredTimers[0].type == 2 && expiredTimers[0].data == 2);
+        TEST_CHECK(!timerWheel.IsActive(kept));
+        TEST_CHECK(!timerWheel.Cancel(kept));
+
+        // The new timers reuse the freed nodes, the old handles must not reach them
+        TimerHandle reused = timerWheel.Schedule(70100, 3, 3);
+        TimerHandle reusedToo = timerWheel.Schedule(70100, 4, 4);
+        TEST_CHECK(reused != cancelled && reused != kept && reusedToo != cancelled && reusedToo != kept);
+        TEST_CHECK(!timerWheel.Cancel(cancelled));
+        TEST_CHECK(!timerWheel.Cancel(kept));
+        TEST_CHECK(timerWheel.IsActive(reused) && timerWheel.IsActive(reusedToo));
+        TEST_CHECK(!timerWheel.IsActive(0));
+
+        expiredTimers.clear();
+        timerWheel.Advance(70100, expiredTimers);
+        TEST_CHECK(expiredTimers.size() == 2);
+    }
+
+    void TestIdleSkip()
+    {
+        TimerWheel timerWheel(1);
+        std::vector<ExpiredTimer> expiredTimers;
+
+        // Nothing scheduled, this can't step through the ticks one by one
+        u64 now = 1ull << 50;
+        timerWheel.Advance(now, expiredTimers);
+        TEST_CHECK(expiredTimers.empty());
+
+        // Counted from where the wheel skipped to
+        timerWheel.Schedule(now + 5, 0, 0);
+        timerWheel.Advance(now + 4, expiredTimers);
+        TEST_CHECK(expiredTimers.empty());
+        timerWheel.Advance(now + 5, expiredTimers);
+        TEST_CHECK(expiredTimers.size() == 1);
+
+        // Going back in time doesn't move the wheel back
+        expiredTimers.clear();
+        timerWheel.Advance(now, expiredTimers);
+        timerWheel.Schedule(now + 6, 0, 0);
+        timerWheel.Advance(now + 6, expiredTimers);
+        TEST_CHECK(expiredTimers.size() == 1);
+    }
+}
+
+int main()
+{
+    TestCascade();
+    TestResolution();
+    TestCancel();
+    TestIdleSkip();
+
+    return TEST_RESULT();
+}